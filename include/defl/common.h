@@ -96,7 +96,35 @@ typedef struct unz__stream_t infl_stream_t;
 typedef struct unz__chunk_t  defl_chunk_t;
 
 /* inflate flags */
-#define INFL_ZLIB 1
+#define INFL_ZLIB    1
+#define INFL_NOCACHE 2 /* large outputs: keep written output out of the cache */
+
+/* one run of inflated output, see infl_view() */
+typedef struct infl_seg_t {
+  const uint8_t *ptr;
+  size_t         len;
+} infl_seg_t;
+
+/* one output segment, see infl_init_iov() */
+typedef struct infl_iov_t {
+  void  *base;
+  size_t len;
+} infl_iov_t;
+
+/* receives inflated output in order, see infl_init_sink(). return UNZ_OK to
+   go on, anything else stops inflating and is returned */
+typedef int (*infl_sink_t)(void *ctx, const uint8_t *p, size_t len);
+
+/* allocator for infl_init_ex(), ctx is passed to each call. alloc returns
+   size bytes aligned to align, 0 for malloc()'s alignment. realloc may be
+   NULL, the stream then allocates, copies and frees. free and realloc get the
+   size the block was allocated with */
+typedef struct infl_alloc_t {
+  void *(*alloc)(void *ctx, size_t size, size_t align);
+  void *(*realloc)(void *ctx, void *p, size_t oldsize, size_t size);
+  void  (*free)(void *ctx, void *p, size_t size);
+  void   *ctx;
+} infl_alloc_t;
 
 #ifdef __cplusplus
 }
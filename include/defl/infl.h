@@ -30,11 +30,156 @@
  */
 UNZ_EXPORT
 infl_stream_t*
-infl_init(void * __restrict dst, uint32_t dstlen, int flags);
+infl_init(void * __restrict dst, size_t dstlen, int flags);
+
+/*!
+ * @brief initialize inflate stream like infl_init(), with its memory from the
+ *        given allocator
+ *
+ *  the stream itself, chunk structs, 32KB chunk pages, the dynamic table
+ *  cache and infl_view() runs all come from alloc, e.g. a per-request arena.
+ *  a failed allocation fails the call that needed it with UNZ_ENOMEM or
+ *  UNZ_ERR, or drops the chunk in infl_include(), so alloc can enforce a
+ *  budget. see infl_mem_usage() for the bytes the stream holds
+ *
+ * @param[in]     dst       uncompressed data (memory addr to unzip)
+ * @param[in]     dstlen    size of uncompressed data in bytes
+ * @param[in]     flags     pass 1 for zlib header
+ * @param[in]     alloc     allocator, copied. NULL for malloc() and free()
+ *
+ * @returns infl stream to use later
+ */
+UNZ_EXPORT
+infl_stream_t*
+infl_init_ex(void               * __restrict dst,
+             size_t                          dstlen,
+             int                             flags,
+             const infl_alloc_t * __restrict alloc);
+
+/*!
+ * @brief initialize inflate stream that hands its output to a sink instead of
+ *        writing it to a known-size destination
+ *
+ *  the stream keeps the last 32KB of output as its window in a buffer of its
+ *  own, so memory stays the same for any output size. the sink gets the output
+ *  in order in slices of exactly slice bytes, only the last one may be shorter.
+ *  it is called from infl() and infl_stream(), the bytes are only valid during
+ *  the call. a slice is handed over once it is complete, infl_stream() does not
+ *  wait for the end of the stream. infl_resize_output() and infl_view() are not
+ *  available on a sink stream
+ *
+ * @param[in]     sink      receives the output
+ * @param[in]     ctx       passed to sink
+ * @param[in]     slice     slice size in bytes, 0 for 64KB
+ * @param[in]     flags     pass 1 for zlib header
+ *
+ * @returns infl stream to use later
+ */
+UNZ_EXPORT
+infl_stream_t*
+infl_init_sink(infl_sink_t sink, void *ctx, size_t slice, int flags);
+
+/*!
+ * @brief initialize inflate stream that owns its output and grows it as
+ *        needed, for outputs of unknown size
+ *
+ *  the output starts at hint bytes (64KB for 0), e.g. the size a PNG IHDR
+ *  gives, and doubles with the stream's realloc whenever it runs out. infl()
+ *  and infl_stream() go on where they were, a block that ran out is inflated
+ *  again from its start. take the output with infl_take_output(), the stream
+ *  frees it otherwise. infl_resize_output() and infl_view() are not available
+ *  on a growable stream
+ *
+ * @param[in]     hint      expected output size in bytes, 0 if unknown
+ * @param[in]     flags     pass 1 for zlib header
+ *
+ * @returns infl stream to use later
+ */
+UNZ_EXPORT
+infl_stream_t*
+infl_init_grow(size_t hint, int flags);
+
+/*!
+ * @brief initialize inflate stream like infl_init_grow(), with its memory and
+ *        the output from the given allocator
+ *
+ *  the output is allocated, grown and freed through alloc like the rest of
+ *  the stream's memory, see infl_init_ex(). without a realloc the stream
+ *  allocates, copies and frees on each growth
+ *
+ * @param[in]     hint      expected output size in bytes, 0 if unknown
+ * @param[in]     flags     pass 1 for zlib header
+ * @param[in]     alloc     allocator, copied. NULL for malloc() and free()
+ *
+ * @returns infl stream to use later
+ */
+UNZ_EXPORT
+infl_stream_t*
+infl_init_grow_ex(size_t                          hint,
+                  int                             flags,
+                  const infl_alloc_t * __restrict alloc);
+
+/*!
+ * @brief take the output of a stream from infl_init_grow() or
+ *        infl_init_grow_ex()
+ *
+ *  the buffer is first fit to the len bytes inflated, then the caller owns
+ *  it and the stream is left without output. it came from the stream's
+ *  allocator: free it with free() for infl_init_grow(), on windows too, or
+ *  with alloc->free(alloc->ctx, p, len) for infl_init_grow_ex(). NULL when
+ *  nothing was inflated, when fitting the buffer fails (the stream keeps it
+ *  then) and for other streams
+ *
+ * @param[in,out] stream    deflate stream
+ * @param[out]    len       number of bytes inflated, may be NULL
+ */
+UNZ_EXPORT
+uint8_t*
+infl_take_output(infl_stream_t * __restrict stream, size_t * __restrict len);
+
+/*!
+ * @brief initialize inflate stream that fills a list of output segments in
+ *        order, e.g. row buffers or ring buffer parts
+ *
+ *  back-references may reach across segments: the stream keeps the last 32KB
+ *  of output in a shadow buffer. while a segment holds less than 32KB of
+ *  output its bytes are inflated into the shadow and copied in, the rest is
+ *  inflated straight into the segment. the list is copied, the segments must
+ *  stay valid until they are filled. when all are full infl() and
+ *  infl_stream() return UNZ_EFULL, give more with infl_add_iov() and call
+ *  infl_stream(stream, NULL, 0) to go on. infl_resize_output() and infl_view()
+ *  are not available on an iov stream
+ *
+ * @param[in]     iov       output segments, may be NULL if niov is 0
+ * @param[in]     niov      number of segments
+ * @param[in]     flags     pass 1 for zlib header
+ *
+ * @returns infl stream to use later
+ */
+UNZ_EXPORT
+infl_stream_t*
+infl_init_iov(const infl_iov_t * __restrict iov, size_t niov, int flags);
+
+/*!
+ * @brief append output segments to a stream from infl_init_iov()
+ *
+ * @param[in,out] stream    deflate stream
+ * @param[in]     iov       output segments
+ * @param[in]     niov      number of segments
+ */
+UNZ_EXPORT
+int
+infl_add_iov(infl_stream_t    * __restrict stream,
+             const infl_iov_t * __restrict iov,
+             size_t                        niov);
 
 /*!
  * @brief reset an inflate stream for reuse with a new destination
  *
+ *  a stream from infl_init_sink(), infl_init_grow() or infl_init_iov() keeps
+ *  its buffer when dst is NULL, an iov stream drops its segments. a
+ *  destination turns it into a plain stream
+ *
  * @param[in,out] stream    deflate stream
  * @param[in]     dst       uncompressed data destination
  * @param[in]     dstlen    size of uncompressed data in bytes
@@ -44,7 +189,7 @@ UNZ_EXPORT
 void
 infl_reset(infl_stream_t * __restrict stream,
            void          * __restrict dst,
-           uint32_t                   dstlen,
+           size_t                     dstlen,
            int                        flags);
 
 /*!
@@ -61,7 +206,7 @@ UNZ_EXPORT
 int
 infl_resize_output(infl_stream_t * __restrict stream,
                    void          * __restrict dst,
-                   uint32_t                   dstlen);
+                   size_t                     dstlen);
 
 /*!
  * @brief appends a chunk to unzip stream to uncompress, the chunks may be
@@ -79,7 +224,7 @@ UNZ_EXPORT
 void
 infl_include(infl_stream_t * __restrict stream,
              const void    * __restrict ptr,
-             uint32_t                   len);
+             size_t                     len);
 
 /*!
  * @brief inflate given deflated content, all included chunks will be inflated
@@ -93,6 +238,32 @@ UNZ_EXPORT
 int
 infl(infl_stream_t * __restrict stream);
 
+/*!
+ * @brief inflate all included chunks like infl(), without copying stored
+ *        blocks
+ *
+ *  the output is returned as runs that are read in order: the payload of a
+ *  stored (BTYPE=0) block points into the included chunks, huffman coded
+ *  blocks are inflated into dst. payloads made only of stored blocks need no
+ *  dst at all. a huffman block that follows stored data first gets up to 32KB
+ *  of that output copied into dst as its window, so dst needs room for it and
+ *  infl_output_pos() counts it; the output size is the sum of the run lengths
+ *
+ *  small chunks are copied into the stream's own pages by infl_include(), and
+ *  the few payload bytes that were read ahead across a chunk edge are kept by
+ *  the stream, so runs stay valid until the stream is reset or destroyed and
+ *  as long as the included memory and dst are
+ *
+ * @param[in]  stream  deflate stream
+ * @param[out] segs    runs of output, owned by the stream
+ * @param[out] nsegs   number of runs
+ */
+UNZ_EXPORT
+int
+infl_view(infl_stream_t     * __restrict stream,
+          const infl_seg_t ** __restrict segs,
+          size_t            * __restrict nsegs);
+
 /*!
  * @brief reset the chunk pool for reuse - call this after processing
  *        to reuse chunks for the next image without reallocation
@@ -113,35 +284,92 @@ void
 infl_destroy(infl_stream_t * __restrict stream);
 
 /*!
- * @brief inflate given deflated content
+ * @brief get a plain inflate stream like infl_init(), from the calling
+ *        thread's cache when it has one
+ *
+ *  a cached stream keeps its chunk pages, chunk structs and dynamic table
+ *  cache, so short decodes need no allocation and no page faults and repeated
+ *  code lengths skip the table build. give it back with infl_release()
  *
- * @param[in,out] src       deflate stream: NULL to get created one, stream to
- *                          continue unzipping.
- * @param[in]     srclen    compressed data (memory addr to unzip)
- * @param[in]     dst       size of chunk
- * @param[in]     dstlen    size of chunk
+ * @param[in]     dst       uncompressed data (memory addr to unzip)
+ * @param[in]     dstlen    size of uncompressed data in bytes
+ * @param[in]     flags     pass 1 for zlib header
+ *
+ * @returns infl stream to use later
+ */
+UNZ_EXPORT
+infl_stream_t*
+infl_acquire(void * __restrict dst, size_t dstlen, int flags);
+
+/*!
+ * @brief give a stream back to the calling thread's cache, or destroy it
+ *        if the cache is full
+ *
+ *  any stream may be released, only plain ones from infl_init() or
+ *  infl_acquire() are cached, it does not matter which thread made them
+ *
+ * @param[in] stream  deflate stream
+ */
+UNZ_EXPORT
+void
+infl_release(infl_stream_t * __restrict stream);
+
+/*!
+ * @brief set how many streams the calling thread's cache keeps, 4 by default
+ *        and 64 at most
+ *
+ *  streams above the depth are destroyed. a thread's cache is freed when the
+ *  thread exits, infl_cache_depth(0) frees it earlier. the main thread's cache
+ *  is left to the process exit
+ *
+ * @param[in] depth  number of streams
+ */
+UNZ_EXPORT
+void
+infl_cache_depth(unsigned depth);
+
+/*!
+ * @brief inflate a contiguous deflated buffer at once without allocating
+ *
+ *  the stream and the tables of a dynamic block live on the stack (about
+ *  12KB), a block that repeats the previous code lengths reuses its tables
+ *
+ * @param[in]     src       compressed data
+ * @param[in]     srclen    size of compressed data in bytes
+ * @param[in]     dst       uncompressed data destination
+ * @param[in]     dstlen    size of dst in bytes
+ * @param[in]     flags     pass 1 for zlib header
+ * @param[out]    produced  bytes written to dst, may be NULL
+ * @param[out]    consumed  bytes of src read up to the end of the deflate
+ *                          stream, may be NULL
+ */
+UNZ_EXPORT
+int
+infl_once(const void * __restrict src,
+          size_t                  srclen,
+          void       * __restrict dst,
+          size_t                  dstlen,
+          int                     flags,
+          size_t     * __restrict produced,
+          size_t     * __restrict consumed);
+
+/*!
+ * @brief inflate given deflated content, see infl_once()
+ *
+ * @param[in]     src       compressed data
+ * @param[in]     srclen    size of compressed data in bytes
+ * @param[in]     dst       uncompressed data destination
+ * @param[in]     dstlen    size of dst in bytes
  * @param[in]     flags     pass 1 for zlib header
  */
 UNZ_INLINE
 int
 infl_buf(const void * __restrict src,
-         uint32_t                srclen,
+         size_t                  srclen,
          void     * __restrict dst,
-         uint32_t                dstlen,
+         size_t                  dstlen,
          int                     flags) {
-  infl_stream_t *st;
-  int            ret;
-
-  if (!(st = infl_init(dst, dstlen, flags))) {
-    return -1;
-  }
-
-  infl_include(st, src, srclen);
-  ret = infl(st);
-
-  infl_destroy(st);
-
-  return ret;
+  return infl_once(src, srclen, dst, dstlen, flags, NULL, NULL);
 }
 
 /*!
@@ -165,7 +393,31 @@ UNZ_EXPORT
 int
 infl_stream(infl_stream_t * __restrict stream,
             const void    * __restrict src,
-            uint32_t                   srclen);
+            size_t                     srclen);
+
+/*!
+ * @brief inflate stream like infl_stream(), reading src in place instead of
+ *        copying it
+ *
+ *  src is only used during the call. the stream keeps the few bytes it still
+ *  needs of it, at most 16, and consumed tells how much of src it took: all
+ *  of it unless there was more than that left, e.g. after UNZ_EFULL or past
+ *  the end of the deflate stream. pass the rest again with the next call.
+ *  at the end consumed stops at the last deflate byte. a stream takes either
+ *  infl_stream_borrow() or infl_include() / infl_stream() input until
+ *  infl_reset(), infl() is not available on it
+ *
+ * @param[in,out] stream    deflate stream
+ * @param[in]     src       compressed data, may be NULL if srclen is 0
+ * @param[in]     srclen    size of compressed data in bytes
+ * @param[out]    consumed  bytes of src taken, may be NULL
+ */
+UNZ_EXPORT
+int
+infl_stream_borrow(infl_stream_t * __restrict stream,
+                   const void    * __restrict src,
+                   size_t                     srclen,
+                   size_t        * __restrict consumed);
 
 /*!
  * @brief current number of bytes produced by an inflate stream
@@ -173,7 +425,7 @@ infl_stream(infl_stream_t * __restrict stream,
  * @param[in] stream  deflate stream
  */
 UNZ_EXPORT
-uint32_t
+size_t
 infl_output_pos(const infl_stream_t * __restrict stream);
 
 /*!
@@ -185,7 +437,21 @@ infl_output_pos(const infl_stream_t * __restrict stream);
  * @param[in] stream  deflate stream
  */
 UNZ_EXPORT
-uint32_t
+size_t
 infl_input_pos(const infl_stream_t * __restrict stream);
 
+/*!
+ * @brief bytes an inflate stream holds from its allocator, the stream itself
+ *        included, and the most it held at once
+ *
+ * @param[in]  stream  deflate stream
+ * @param[out] inuse   bytes held now, may be NULL
+ * @param[out] peak    most bytes held at once, may be NULL
+ */
+UNZ_EXPORT
+void
+infl_mem_usage(const infl_stream_t * __restrict stream,
+               size_t              * __restrict inuse,
+               size_t              * __restrict peak);
+
 #endif /* infl_h */
@@ -38,6 +38,12 @@
 #  define likely(expr)   (expr)
 #endif
 
+#if defined(_MSC_VER)
+#  define UNZ_TLS __declspec(thread)
+#else
+#  define UNZ_TLS _Thread_local
+#endif
+
 #define ARRAY_LEN(ARR) (sizeof(ARR) / sizeof(ARR[0]))
 
 /* chunk pool configuration - optimization for PNG IDAT chunks */
@@ -45,8 +51,8 @@
 #define UNZ_CHUNK_PAGE_SIZE 32768       /* 32KB - typical for PNG IDAT       */
 #define UNZ_CHUNK_APPEND_THRESHOLD 8192 /* 8KB - append if smaller than this */
 
-/* chunk structure pool - for reducing calloc overhead */
-#define UNZ_CHUNK_STRUCT_POOL_SIZE 1024 /* for large images                  */
+/* chunk structs are allocated this many at a time */
+#define UNZ_CHUNK_SLAB_SIZE 16
 
 /* cache line size for alignment */
 #define CACHE_LINE_SIZE 64
@@ -54,6 +60,71 @@
 #define MAX_CODELEN_CODES 19
 #define MAX_LITLEN_CODES  288
 #define MAX_DIST_CODES    32
+#define INFL_WINDOW       32768u /* farthest a back-reference can reach */
+
+/* infl_init_sink(): default slice, and the room kept past window + slice
+   for the longest match, stored blocks are copied in parts */
+#define INFL_SINK_SLICE   65536u
+#define INFL_SINK_SLACK   258u
+
+/* infl_acquire(): streams kept per thread for reuse, by default and at most */
+#define INFL_CACHE_DEPTH  4u
+#define INFL_CACHE_MAX    64u
+
+/* infl_stream_borrow(): input bytes kept between calls, the whole bytes of the
+   bit buffer and a short unread rest */
+#define INFL_BORROW_TAIL  16u
+
+/* infl_init_grow(): first output size without a hint */
+#define INFL_GROW_MIN     65536u
+
+/* INFL_NOCACHE: stored copies at least this long go past the cache, huffman
+   output a window behind the cursor is evicted once a batch has piled up */
+#define INFL_NOCACHE_COPY  4096u
+#define INFL_NOCACHE_BATCH (256u * 1024u)
+
+/* fast decode tables: main table bits and capacity including subtables */
+#define INFL_FT_LIT_BITS    10u
+#define INFL_FT_DIST_BITS   8u
+#define INFL_FT_LIT_MAIN    (1u << INFL_FT_LIT_BITS)
+#define INFL_FT_DIST_MAIN   (1u << INFL_FT_DIST_BITS)
+#define INFL_FT_LIT_CAP     2048u
+#define INFL_FT_DIST_CAP    512u
+
+/* narrowest a dynamic block's table is built at, the main table width turns
+   the narrow builds off */
+#ifndef INFL_FT_BUILD_MIN
+#  define INFL_FT_BUILD_MIN 6u
+#endif
+
+/* pack two short literal codes into one main-table entry */
+#ifndef INFL_FT_LITPAIRS
+#  define INFL_FT_LITPAIRS  1
+#endif
+
+/* give a length/distance code whose extra bits also fit in the main table one
+   entry per extra-bits value with the base already added */
+#ifndef INFL_FT_PREXBITS
+#  define INFL_FT_PREXBITS  1
+#endif
+
+/* prefetch the source of a match at least this many bytes back as soon as its
+   distance is decoded. off by default: the 32KB window is normally still in
+   l1/l2, so this only pays where the output is cold (e.g. written by another
+   core or evicted by a large sink between calls) */
+#ifndef INFL_FT_PREFETCH
+#  define INFL_FT_PREFETCH  0
+#endif
+
+/* build bmi2/avx2/avx-512 variants of the decode loop and pick one at first use,
+   gcc/clang on x86 only */
+#ifndef INFL_FT_DISPATCH
+#  define INFL_FT_DISPATCH  1
+#endif
+#if INFL_FT_DISPATCH && !(defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)))
+#  undef  INFL_FT_DISPATCH
+#  define INFL_FT_DISPATCH  0
+#endif
 
 typedef struct unz__chunk_t  unz_chunk_t;
 typedef struct unz__chunk_t  defl_chunk_t;
@@ -66,10 +137,50 @@ struct unz__chunk_t {
   uint8_t             *buffer;        /* owned buffer for appendable chunks  */
   size_t               buffer_size;   /* total buffer size                   */
   size_t               used;          /* used bytes in buffer                */
-  bool                 is_pooled;     /* true if from pre-allocated pool     */
   bool                 is_appendable; /* true if we can append to this chunk */
 };
 
+/* a pooled 32KB page with the chunk that appends to it */
+typedef struct unz_chunk_page_t {
+  unz_chunk_t              chk;
+  struct unz_chunk_page_t *next;
+  UNZ_ALIGN(64) uint8_t    buffer[UNZ_CHUNK_PAGE_SIZE];
+} unz_chunk_page_t;
+
+/* chunk structs for chunks that point into the input */
+typedef struct unz_chunk_slab_t {
+  struct unz_chunk_slab_t *next;
+  unz_chunk_t              chk[UNZ_CHUNK_SLAB_SIZE];
+} unz_chunk_slab_t;
+
+typedef struct infl_ft_table_t {
+  UNZ_ALIGN(64) uint32_t table[INFL_FT_LIT_CAP];
+  uint16_t used;
+} infl_ft_table_t;
+
+typedef struct infl_ft_dist_table_t {
+  UNZ_ALIGN(64) uint32_t table[INFL_FT_DIST_CAP];
+  uint16_t used;
+} infl_ft_dist_table_t;
+
+/* tables built from one dynamic block header, kept per stream so a block that
+   repeats the previous code lengths skips the build */
+#define INFL_FT_CACHE_SIZE  4
+
+typedef struct infl_ft_dyn_t {
+  infl_ft_table_t      tlit;
+  infl_ft_dist_table_t tdist;
+  uint32_t             hash;
+  uint16_t             hlit;
+  uint16_t             n;     /* hlit + hdist, 0 for an empty slot */
+  uint8_t              lens[MAX_LITLEN_CODES + MAX_DIST_CODES];
+} infl_ft_dyn_t;
+
+typedef struct infl_ft_cache_t {
+  infl_ft_dyn_t ent[INFL_FT_CACHE_SIZE];
+  unsigned      next;         /* slot replaced on the next miss */
+} infl_ft_cache_t;
+
 #define BITS_TYPE uint_fast64_t
 #define BITS_SZF  (sizeof(BITS_TYPE)*8)
 
@@ -116,25 +227,24 @@ typedef struct {
   block_decode_state_t state;
   unsigned len;
   unsigned dist;
-  unsigned src;
+  size_t   src;
   unsigned copy_remaining;
 } block_state_t;
 
 typedef struct {
-  int              hlit;
-  int              hdist;
-  int              hclen;
-  int              n;
-  int              i;
-  int              repeat;
-  int              prev;
-  uint8_t          codelens[MAX_CODELEN_CODES];
-  uint8_t          lens[MAX_LITLEN_CODES + MAX_DIST_CODES];
-  huff_table_ext_t tlit;
-  huff_table_ext_t tdist;
-  uint8_t          tlit_valid;
-  uint8_t          tdist_valid;
-  uint8_t          codelen_done;
+  int                  hlit;
+  int                  hdist;
+  int                  hclen;
+  int                  n;
+  int                  i;
+  int                  repeat;
+  int                  prev;
+  uint8_t              codelens[MAX_CODELEN_CODES];
+  uint8_t              lens[MAX_LITLEN_CODES + MAX_DIST_CODES];
+  const infl_ft_dyn_t *tabs;
+  uint8_t              tlit_valid;
+  uint8_t              tdist_valid;
+  uint8_t              codelen_done;
 } dynamic_block_state_t;
 
 typedef struct unz__streaming_state_t {
@@ -154,13 +264,13 @@ struct unz__stream_t {
 
   void                  *header;
 
-  void                  *(*malloc)(size_t);
-  void                  *(*realloc)(void *, size_t);
-  void                   (*free)(void *);
+  infl_alloc_t           mem;     /* every allocation goes through it */
+  size_t                 meminuse;
+  size_t                 mempeak;
 
   size_t                 bitpos; /* bit position in all */
   uint8_t               *dst;
-  uint32_t               dstlen;
+  size_t                 dstlen;
   size_t                 dstpos;
   size_t                 srclen; /* sum_of(chunk->len)  */
   int                    flags;
@@ -168,15 +278,58 @@ struct unz__stream_t {
   unz__bitstate_t        bs;
   unz__streaming_state_t ss;
 
-  /* chunk pool management */
-  unz_chunk_t           *chunk_pool[UNZ_CHUNK_POOL_SIZE];
-  uint8_t               *chunk_buffers[UNZ_CHUNK_POOL_SIZE];
-  int                    pool_used;
+  /* chunk pools, grown on demand and handed out again in order after
+     infl_reset_pool(). page / slab is the last one in use, NULL for none */
+  unz_chunk_page_t      *pages;
+  unz_chunk_page_t      *page;
+  int                    pool_used; /* pages in use, UNZ_CHUNK_POOL_SIZE max */
   unz_chunk_t           *current_appendable; /* current chunk for appending small data */
 
-  /* chunk structure pool - for non-appendable chunks */
-  unz_chunk_t           *chunk_struct_pool[UNZ_CHUNK_STRUCT_POOL_SIZE];
-  int                    struct_pool_used;
+  unz_chunk_slab_t      *slabs;
+  unz_chunk_slab_t      *slab;
+  int                    slab_used; /* chunks in use from slab              */
+
+  infl_ft_cache_t       *ftcache; /* allocated on the first dynamic block */
+  infl_ft_dyn_t         *ftone;   /* infl_once(): the only tables, no cache */
+
+  /* infl_init_sink(): dst is a window + slice + slack buffer owned by the
+     stream, dstpos is relative to it */
+  infl_sink_t            sink;
+  void                  *sinkctx;
+  size_t                 slice;
+  size_t                 flushed; /* dst bytes before this went to the sink  */
+  size_t                 slid;    /* bytes dropped from the front of dst     */
+
+  bool                   grow;    /* infl_init_grow(): dst is owned, grown   */
+
+  /* infl_init_iov(): segments filled in order. dst is the segment itself
+     once it holds a window of output, else the shadow: the last window
+     followed by the bytes that are copied out to the segments next */
+  infl_iov_t            *iov;
+  size_t                 niov;
+  size_t                 iovcap;
+  size_t                 iovi;    /* segment being filled                    */
+  size_t                 iovoff;  /* bytes in it                             */
+  size_t                 iovdone; /* bytes in the segments before it         */
+  uint8_t               *shadow;  /* INFL_WINDOW * 2, flushed as in a sink   */
+  bool                   iovdirect;
+
+  /* infl_stream_borrow(): the chain is tailchk, then srcchk over the
+     caller's buffer during a call. between calls only tail is kept */
+  unz_chunk_t            tailchk;
+  unz_chunk_t            srcchk;
+  uint8_t                tail[INFL_BORROW_TAIL];
+  size_t                 ntail;
+  size_t                 dropped; /* input bytes before tail             */
+  bool                   borrowed;
+
+  /* infl_view() output runs, grown with infl_mem_realloc() */
+  infl_seg_t            *segs;
+  size_t                 nsegs;
+  size_t                 segcap;
+  uint8_t               *edge;    /* stored bytes whose chunk was behind   */
+  size_t                 nedge;
+  size_t                 edgecap;
 
   /* statistics for tuning (optional - can be ifdef'd out in release) */
 #ifdef UNZ_STATS
@@ -184,6 +337,9 @@ struct unz__stream_t {
   size_t                 total_directs;
   size_t                 pool_hits;
   size_t                 pool_misses;
+  size_t                 table_cache_hits;
+  size_t                 table_cache_misses;
+  uint64_t               table_build_cycles; /* infl_ft_tables() on cache misses */
 #endif
 };
 
@@ -25,8 +25,10 @@
 #  include <arm_neon.h>
 #endif
 
-#if defined(__AVX2__)
+#if defined(__AVX2__) || defined(__CLFLUSHOPT__)
 #  include <immintrin.h>
+#elif defined(__SSE2__)
+#  include <emmintrin.h>
 #endif
 
 #define MAX_CODELEN_CODES 19
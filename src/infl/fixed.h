@@ -0,0 +1,233 @@
+/* fixed.h -- fixed huffman decode tables for INFL_FT_LIT_BITS 10 and
+ * INFL_FT_DIST_BITS 8, generated by infl_ft_makefixed() in ft.c
+ */
+
+#if INFL_FT_LIT_BITS != 10u || INFL_FT_DIST_BITS != 8u
+#  error "fixed.h is stale, regenerate it with infl_ft_makefixed()"
+#endif
+
+UNZ_HIDE const infl_ft_table_t infl_ft_fixed_lit = {
+  {
+    0x000040e7u, 0x00502108u, 0x00102108u, 0x0073090cu, 0x001f0129u, 0x00702108u,
+    0x00302108u, 0x00c02129u, 0x000a00e7u, 0x00602108u, 0x00202108u, 0x00a02129u,
+    0x00002108u, 0x00802108u, 0x00402108u, 0x00e02129u, 0x000600e7u, 0x00582108u,
+    0x00182108u, 0x00902129u, 0x003b014au, 0x00782108u, 0x00382108u, 0x00d02129u,
+    0x00110108u, 0x00682108u, 0x00282108u, 0x00b02129u, 0x00082108u, 0x00882108u,
+    0x00482108u, 0x00f02129u, 0x000400e7u, 0x00542108u, 0x00142108u, 0x00e30b0du,
+    0x002b014au, 0x00742108u, 0x00342108u, 0x00c82129u, 0x000d0108u, 0x00642108u,
+    0x00242108u, 0x00a82129u, 0x00042108u, 0x00842108u, 0x00442108u, 0x00e82129u,
+    0x000800e7u, 0x005c2108u, 0x001c2108u, 0x00982129u, 0x005308ebu, 0x007c2108u,
+    0x003c2108u, 0x00d82129u, 0x00170129u, 0x006c2108u, 0x002c2108u, 0x00b82129u,
+    0x000c2108u, 0x008c2108u, 0x004c2108u, 0x00f82129u, 0x000300e7u, 0x00522108u,
+    0x00122108u, 0x00a30b0du, 0x0023014au, 0x00722108u, 0x00322108u, 0x00c42129u,
+    0x000b0108u, 0x00622108u, 0x00222108u, 0x00a42129u, 0x00022108u, 0x00822108u,
+    0x00422108u, 0x00e42129u, 0x000700e7u, 0x005a2108u, 0x001a2108u, 0x00942129u,
+    0x004308ebu, 0x007a2108u, 0x003a2108u, 0x00d42129u, 0x00130129u, 0x006a2108u,
+    0x002a2108u, 0x00b42129u, 0x000a2108u, 0x008a2108u, 0x004a2108u, 0x00f42129u,
+    0x000500e7u, 0x00562108u, 0x00162108u, 0x00000000u, 0x0033014au, 0x00762108u,
+    0x00362108u, 0x00cc2129u, 0x000f0108u, 0x00662108u, 0x00262108u, 0x00ac2129u,
+    0x00062108u, 0x00862108u, 0x00462108u, 0x00ec2129u, 0x000900e7u, 0x005e2108u,
+    0x001e2108u, 0x009c2129u, 0x006308ebu, 0x007e2108u, 0x003e2108u, 0x00dc2129u,
+    0x001b0129u, 0x006e2108u, 0x002e2108u, 0x00bc2129u, 0x000e2108u, 0x008e2108u,
+    0x004e2108u, 0x00fc2129u, 0x000040e7u, 0x00512108u, 0x00112108u, 0x00830b0du,
+    0x00200129u, 0x00712108u, 0x00312108u, 0x00c22129u, 0x000a00e7u, 0x00612108u,
+    0x00212108u, 0x00a22129u, 0x00012108u, 0x00812108u, 0x00412108u, 0x00e22129u,
+    0x000600e7u, 0x00592108u, 0x00192108u, 0x00922129u, 0x003c014au, 0x00792108u,
+    0x00392108u, 0x00d22129u, 0x00120108u, 0x00692108u, 0x00292108u, 0x00b22129u,
+    0x00092108u, 0x00892108u, 0x00492108u, 0x00f22129u, 0x000400e7u, 0x00552108u,
+    0x00152108u, 0x01020108u, 0x002c014au, 0x00752108u, 0x00352108u, 0x00ca2129u,
+    0x000e0108u, 0x00652108u, 0x00252108u, 0x00aa2129u, 0x00052108u, 0x00852108u,
+    0x00452108u, 0x00ea2129u, 0x000800e7u, 0x005d2108u, 0x001d2108u, 0x009a2129u,
+    0x005308ebu, 0x007d2108u, 0x003d2108u, 0x00da2129u, 0x00180129u, 0x006d2108u,
+    0x002d2108u, 0x00ba2129u, 0x000d2108u, 0x008d2108u, 0x004d2108u, 0x00fa2129u,
+    0x000300e7u, 0x00532108u, 0x00132108u, 0x00c30b0du, 0x0024014au, 0x00732108u,
+    0x00332108u, 0x00c62129u, 0x000c0108u, 0x00632108u, 0x00232108u, 0x00a62129u,
+    0x00032108u, 0x00832108u, 0x00432108u, 0x00e62129u, 0x000700e7u, 0x005b2108u,
+    0x001b2108u, 0x00962129u, 0x004308ebu, 0x007b2108u, 0x003b2108u, 0x00d62129u,
+    0x00140129u, 0x006b2108u, 0x002b2108u, 0x00b62129u, 0x000b2108u, 0x008b2108u,
+    0x004b2108u, 0x00f62129u, 0x000500e7u, 0x00572108u, 0x00172108u, 0x00000000u,
+    0x0034014au, 0x00772108u, 0x00372108u, 0x00ce2129u, 0x00100108u, 0x00672108u,
+    0x00272108u, 0x00ae2129u, 0x00072108u, 0x00872108u, 0x00472108u, 0x00ee2129u,
+    0x000900e7u, 0x005f2108u, 0x001f2108u, 0x009e2129u, 0x006308ebu, 0x007f2108u,
+    0x003f2108u, 0x00de2129u, 0x001c0129u, 0x006f2108u, 0x002f2108u, 0x00be2129u,
+    0x000f2108u, 0x008f2108u, 0x004f2108u, 0x00fe2129u, 0x000040e7u, 0x00502108u,
+    0x00102108u, 0x0073090cu, 0x00210129u, 0x00702108u, 0x00302108u, 0x00c12129u,
+    0x000a00e7u, 0x00602108u, 0x00202108u, 0x00a12129u, 0x00002108u, 0x00802108u,
+    0x00402108u, 0x00e12129u, 0x000600e7u, 0x00582108u, 0x00182108u, 0x00912129u,
+    0x003d014au, 0x00782108u, 0x00382108u, 0x00d12129u, 0x00110108u, 0x00682108u,
+    0x00282108u, 0x00b12129u, 0x00082108u, 0x00882108u, 0x00482108u, 0x00f12129u,
+    0x000400e7u, 0x00542108u, 0x00142108u, 0x00e30b0du, 0x002d014au, 0x00742108u,
+    0x00342108u, 0x00c92129u, 0x000d0108u, 0x00642108u, 0x00242108u, 0x00a92129u,
+    0x00042108u, 0x00842108u, 0x00442108u, 0x00e92129u, 0x000800e7u, 0x005c2108u,
+    0x001c2108u, 0x00992129u, 0x005308ebu, 0x007c2108u, 0x003c2108u, 0x00d92129u,
+    0x00190129u, 0x006c2108u, 0x002c2108u, 0x00b92129u, 0x000c2108u, 0x008c2108u,
+    0x004c2108u, 0x00f92129u, 0x000300e7u, 0x00522108u, 0x00122108u, 0x00a30b0du,
+    0x0025014au, 0x00722108u, 0x00322108u, 0x00c52129u, 0x000b0108u, 0x00622108u,
+    0x00222108u, 0x00a52129u, 0x00022108u, 0x00822108u, 0x00422108u, 0x00e52129u,
+    0x000700e7u, 0x005a2108u, 0x001a2108u, 0x00952129u, 0x004308ebu, 0x007a2108u,
+    0x003a2108u, 0x00d52129u, 0x00150129u, 0x006a2108u, 0x002a2108u, 0x00b52129u,
+    0x000a2108u, 0x008a2108u, 0x004a2108u, 0x00f52129u, 0x000500e7u, 0x00562108u,
+    0x00162108u, 0x00000000u, 0x0035014au, 0x00762108u, 0x00362108u, 0x00cd2129u,
+    0x000f0108u, 0x00662108u, 0x00262108u, 0x00ad2129u, 0x00062108u, 0x00862108u,
+    0x00462108u, 0x00ed2129u, 0x000900e7u, 0x005e2108u, 0x001e2108u, 0x009d2129u,
+    0x006308ebu, 0x007e2108u, 0x003e2108u, 0x00dd2129u, 0x001d0129u, 0x006e2108u,
+    0x002e2108u, 0x00bd2129u, 0x000e2108u, 0x008e2108u, 0x004e2108u, 0x00fd2129u,
+    0x000040e7u, 0x00512108u, 0x00112108u, 0x00830b0du, 0x00220129u, 0x00712108u,
+    0x00312108u, 0x00c32129u, 0x000a00e7u, 0x00612108u, 0x00212108u, 0x00a32129u,
+    0x00012108u, 0x00812108u, 0x00412108u, 0x00e32129u, 0x000600e7u, 0x00592108u,
+    0x00192108u, 0x00932129u, 0x003e014au, 0x00792108u, 0x00392108u, 0x00d32129u,
+    0x00120108u, 0x00692108u, 0x00292108u, 0x00b32129u, 0x00092108u, 0x00892108u,
+    0x00492108u, 0x00f32129u, 0x000400e7u, 0x00552108u, 0x00152108u, 0x01020108u,
+    0x002e014au, 0x00752108u, 0x00352108u, 0x00cb2129u, 0x000e0108u, 0x00652108u,
+    0x00252108u, 0x00ab2129u, 0x00052108u, 0x00852108u, 0x00452108u, 0x00eb2129u,
+    0x000800e7u, 0x005d2108u, 0x001d2108u, 0x009b2129u, 0x005308ebu, 0x007d2108u,
+    0x003d2108u, 0x00db2129u, 0x001a0129u, 0x006d2108u, 0x002d2108u, 0x00bb2129u,
+    0x000d2108u, 0x008d2108u, 0x004d2108u, 0x00fb2129u, 0x000300e7u, 0x00532108u,
+    0x00132108u, 0x00c30b0du, 0x0026014au, 0x00732108u, 0x00332108u, 0x00c72129u,
+    0x000c0108u, 0x00632108u, 0x00232108u, 0x00a72129u, 0x00032108u, 0x00832108u,
+    0x00432108u, 0x00e72129u, 0x000700e7u, 0x005b2108u, 0x001b2108u, 0x00972129u,
+    0x004308ebu, 0x007b2108u, 0x003b2108u, 0x00d72129u, 0x00160129u, 0x006b2108u,
+    0x002b2108u, 0x00b72129u, 0x000b2108u, 0x008b2108u, 0x004b2108u, 0x00f72129u,
+    0x000500e7u, 0x00572108u, 0x00172108u, 0x00000000u, 0x0036014au, 0x00772108u,
+    0x00372108u, 0x00cf2129u, 0x00100108u, 0x00672108u, 0x00272108u, 0x00af2129u,
+    0x00072108u, 0x00872108u, 0x00472108u, 0x00ef2129u, 0x000900e7u, 0x005f2108u,
+    0x001f2108u, 0x009f2129u, 0x006308ebu, 0x007f2108u, 0x003f2108u, 0x00df2129u,
+    0x001e0129u, 0x006f2108u, 0x002f2108u, 0x00bf2129u, 0x000f2108u, 0x008f2108u,
+    0x004f2108u, 0x00ff2129u, 0x000040e7u, 0x00502108u, 0x00102108u, 0x0073090cu,
+    0x001f0129u, 0x00702108u, 0x00302108u, 0x00c02129u, 0x000a00e7u, 0x00602108u,
+    0x00202108u, 0x00a02129u, 0x00002108u, 0x00802108u, 0x00402108u, 0x00e02129u,
+    0x000600e7u, 0x00582108u, 0x00182108u, 0x00902129u, 0x003f014au, 0x00782108u,
+    0x00382108u, 0x00d02129u, 0x00110108u, 0x00682108u, 0x00282108u, 0x00b02129u,
+    0x00082108u, 0x00882108u, 0x00482108u, 0x00f02129u, 0x000400e7u, 0x00542108u,
+    0x00142108u, 0x00e30b0du, 0x002f014au, 0x00742108u, 0x00342108u, 0x00c82129u,
+    0x000d0108u, 0x00642108u, 0x00242108u, 0x00a82129u, 0x00042108u, 0x00842108u,
+    0x00442108u, 0x00e82129u, 0x000800e7u, 0x005c2108u, 0x001c2108u, 0x00982129u,
+    0x005308ebu, 0x007c2108u, 0x003c2108u, 0x00d82129u, 0x00170129u, 0x006c2108u,
+    0x002c2108u, 0x00b82129u, 0x000c2108u, 0x008c2108u, 0x004c2108u, 0x00f82129u,
+    0x000300e7u, 0x00522108u, 0x00122108u, 0x00a30b0du, 0x0027014au, 0x00722108u,
+    0x00322108u, 0x00c42129u, 0x000b0108u, 0x00622108u, 0x00222108u, 0x00a42129u,
+    0x00022108u, 0x00822108u, 0x00422108u, 0x00e42129u, 0x000700e7u, 0x005a2108u,
+    0x001a2108u, 0x00942129u, 0x004308ebu, 0x007a2108u, 0x003a2108u, 0x00d42129u,
+    0x00130129u, 0x006a2108u, 0x002a2108u, 0x00b42129u, 0x000a2108u, 0x008a2108u,
+    0x004a2108u, 0x00f42129u, 0x000500e7u, 0x00562108u, 0x00162108u, 0x00000000u,
+    0x0037014au, 0x00762108u, 0x00362108u, 0x00cc2129u, 0x000f0108u, 0x00662108u,
+    0x00262108u, 0x00ac2129u, 0x00062108u, 0x00862108u, 0x00462108u, 0x00ec2129u,
+    0x000900e7u, 0x005e2108u, 0x001e2108u, 0x009c2129u, 0x006308ebu, 0x007e2108u,
+    0x003e2108u, 0x00dc2129u, 0x001b0129u, 0x006e2108u, 0x002e2108u, 0x00bc2129u,
+    0x000e2108u, 0x008e2108u, 0x004e2108u, 0x00fc2129u, 0x000040e7u, 0x00512108u,
+    0x00112108u, 0x00830b0du, 0x00200129u, 0x00712108u, 0x00312108u, 0x00c22129u,
+    0x000a00e7u, 0x00612108u, 0x00212108u, 0x00a22129u, 0x00012108u, 0x00812108u,
+    0x00412108u, 0x00e22129u, 0x000600e7u, 0x00592108u, 0x00192108u, 0x00922129u,
+    0x0040014au, 0x00792108u, 0x00392108u, 0x00d22129u, 0x00120108u, 0x00692108u,
+    0x00292108u, 0x00b22129u, 0x00092108u, 0x00892108u, 0x00492108u, 0x00f22129u,
+    0x000400e7u, 0x00552108u, 0x00152108u, 0x01020108u, 0x0030014au, 0x00752108u,
+    0x00352108u, 0x00ca2129u, 0x000e0108u, 0x00652108u, 0x00252108u, 0x00aa2129u,
+    0x00052108u, 0x00852108u, 0x00452108u, 0x00ea2129u, 0x000800e7u, 0x005d2108u,
+    0x001d2108u, 0x009a2129u, 0x005308ebu, 0x007d2108u, 0x003d2108u, 0x00da2129u,
+    0x00180129u, 0x006d2108u, 0x002d2108u, 0x00ba2129u, 0x000d2108u, 0x008d2108u,
+    0x004d2108u, 0x00fa2129u, 0x000300e7u, 0x00532108u, 0x00132108u, 0x00c30b0du,
+    0x0028014au, 0x00732108u, 0x00332108u, 0x00c62129u, 0x000c0108u, 0x00632108u,
+    0x00232108u, 0x00a62129u, 0x00032108u, 0x00832108u, 0x00432108u, 0x00e62129u,
+    0x000700e7u, 0x005b2108u, 0x001b2108u, 0x00962129u, 0x004308ebu, 0x007b2108u,
+    0x003b2108u, 0x00d62129u, 0x00140129u, 0x006b2108u, 0x002b2108u, 0x00b62129u,
+    0x000b2108u, 0x008b2108u, 0x004b2108u, 0x00f62129u, 0x000500e7u, 0x00572108u,
+    0x00172108u, 0x00000000u, 0x0038014au, 0x00772108u, 0x00372108u, 0x00ce2129u,
+    0x00100108u, 0x00672108u, 0x00272108u, 0x00ae2129u, 0x00072108u, 0x00872108u,
+    0x00472108u, 0x00ee2129u, 0x000900e7u, 0x005f2108u, 0x001f2108u, 0x009e2129u,
+    0x006308ebu, 0x007f2108u, 0x003f2108u, 0x00de2129u, 0x001c0129u, 0x006f2108u,
+    0x002f2108u, 0x00be2129u, 0x000f2108u, 0x008f2108u, 0x004f2108u, 0x00fe2129u,
+    0x000040e7u, 0x00502108u, 0x00102108u, 0x0073090cu, 0x00210129u, 0x00702108u,
+    0x00302108u, 0x00c12129u, 0x000a00e7u, 0x00602108u, 0x00202108u, 0x00a12129u,
+    0x00002108u, 0x00802108u, 0x00402108u, 0x00e12129u, 0x000600e7u, 0x00582108u,
+    0x00182108u, 0x00912129u, 0x0041014au, 0x00782108u, 0x00382108u, 0x00d12129u,
+    0x00110108u, 0x00682108u, 0x00282108u, 0x00b12129u, 0x00082108u, 0x00882108u,
+    0x00482108u, 0x00f12129u, 0x000400e7u, 0x00542108u, 0x00142108u, 0x00e30b0du,
+    0x0031014au, 0x00742108u, 0x00342108u, 0x00c92129u, 0x000d0108u, 0x00642108u,
+    0x00242108u, 0x00a92129u, 0x00042108u, 0x00842108u, 0x00442108u, 0x00e92129u,
+    0x000800e7u, 0x005c2108u, 0x001c2108u, 0x00992129u, 0x005308ebu, 0x007c2108u,
+    0x003c2108u, 0x00d92129u, 0x00190129u, 0x006c2108u, 0x002c2108u, 0x00b92129u,
+    0x000c2108u, 0x008c2108u, 0x004c2108u, 0x00f92129u, 0x000300e7u, 0x00522108u,
+    0x00122108u, 0x00a30b0du, 0x0029014au, 0x00722108u, 0x00322108u, 0x00c52129u,
+    0x000b0108u, 0x00622108u, 0x00222108u, 0x00a52129u, 0x00022108u, 0x00822108u,
+    0x00422108u, 0x00e52129u, 0x000700e7u, 0x005a2108u, 0x001a2108u, 0x00952129u,
+    0x004308ebu, 0x007a2108u, 0x003a2108u, 0x00d52129u, 0x00150129u, 0x006a2108u,
+    0x002a2108u, 0x00b52129u, 0x000a2108u, 0x008a2108u, 0x004a2108u, 0x00f52129u,
+    0x000500e7u, 0x00562108u, 0x00162108u, 0x00000000u, 0x0039014au, 0x00762108u,
+    0x00362108u, 0x00cd2129u, 0x000f0108u, 0x00662108u, 0x00262108u, 0x00ad2129u,
+    0x00062108u, 0x00862108u, 0x00462108u, 0x00ed2129u, 0x000900e7u, 0x005e2108u,
+    0x001e2108u, 0x009d2129u, 0x006308ebu, 0x007e2108u, 0x003e2108u, 0x00dd2129u,
+    0x001d0129u, 0x006e2108u, 0x002e2108u, 0x00bd2129u, 0x000e2108u, 0x008e2108u,
+    0x004e2108u, 0x00fd2129u, 0x000040e7u, 0x00512108u, 0x00112108u, 0x00830b0du,
+    0x00220129u, 0x00712108u, 0x00312108u, 0x00c32129u, 0x000a00e7u, 0x00612108u,
+    0x00212108u, 0x00a32129u, 0x00012108u, 0x00812108u, 0x00412108u, 0x00e32129u,
+    0x000600e7u, 0x00592108u, 0x00192108u, 0x00932129u, 0x0042014au, 0x00792108u,
+    0x00392108u, 0x00d32129u, 0x00120108u, 0x00692108u, 0x00292108u, 0x00b32129u,
+    0x00092108u, 0x00892108u, 0x00492108u, 0x00f32129u, 0x000400e7u, 0x00552108u,
+    0x00152108u, 0x01020108u, 0x0032014au, 0x00752108u, 0x00352108u, 0x00cb2129u,
+    0x000e0108u, 0x00652108u, 0x00252108u, 0x00ab2129u, 0x00052108u, 0x00852108u,
+    0x00452108u, 0x00eb2129u, 0x000800e7u, 0x005d2108u, 0x001d2108u, 0x009b2129u,
+    0x005308ebu, 0x007d2108u, 0x003d2108u, 0x00db2129u, 0x001a0129u, 0x006d2108u,
+    0x002d2108u, 0x00bb2129u, 0x000d2108u, 0x008d2108u, 0x004d2108u, 0x00fb2129u,
+    0x000300e7u, 0x00532108u, 0x00132108u, 0x00c30b0du, 0x002a014au, 0x00732108u,
+    0x00332108u, 0x00c72129u, 0x000c0108u, 0x00632108u, 0x00232108u, 0x00a72129u,
+    0x00032108u, 0x00832108u, 0x00432108u, 0x00e72129u, 0x000700e7u, 0x005b2108u,
+    0x001b2108u, 0x00972129u, 0x004308ebu, 0x007b2108u, 0x003b2108u, 0x00d72129u,
+    0x00160129u, 0x006b2108u, 0x002b2108u, 0x00b72129u, 0x000b2108u, 0x008b2108u,
+    0x004b2108u, 0x00f72129u, 0x000500e7u, 0x00572108u, 0x00172108u, 0x00000000u,
+    0x003a014au, 0x00772108u, 0x00372108u, 0x00cf2129u, 0x00100108u, 0x00672108u,
+    0x00272108u, 0x00af2129u, 0x00072108u, 0x00872108u, 0x00472108u, 0x00ef2129u,
+    0x000900e7u, 0x005f2108u, 0x001f2108u, 0x009f2129u, 0x006308ebu, 0x007f2108u,
+    0x003f2108u, 0x00df2129u, 0x001e0129u, 0x006f2108u, 0x002f2108u, 0x00bf2129u,
+    0x000f2108u, 0x008f2108u, 0x004f2108u, 0x00ff2129u
+  },
+  1024
+};
+
+UNZ_HIDE const infl_ft_dist_table_t infl_ft_fixed_dist = {
+  {
+    0x000100a5u, 0x01010eacu, 0x001106a8u, 0x100116b0u, 0x000500c6u, 0x040112aeu,
+    0x00410aaau, 0x40011ab2u, 0x000300a5u, 0x020110adu, 0x002108a9u, 0x200118b1u,
+    0x000904a7u, 0x080114afu, 0x00810cabu, 0x00000000u, 0x000200a5u, 0x01810eacu,
+    0x001906a8u, 0x180116b0u, 0x000700c6u, 0x060112aeu, 0x00610aaau, 0x60011ab2u,
+    0x000400a5u, 0x030110adu, 0x003108a9u, 0x300118b1u, 0x000d04a7u, 0x0c0114afu,
+    0x00c10cabu, 0x00000000u, 0x000100a5u, 0x01010eacu, 0x001106a8u, 0x100116b0u,
+    0x000600c6u, 0x040112aeu, 0x00410aaau, 0x40011ab2u, 0x000300a5u, 0x020110adu,
+    0x002108a9u, 0x200118b1u, 0x000904a7u, 0x080114afu, 0x00810cabu, 0x00000000u,
+    0x000200a5u, 0x01810eacu, 0x001906a8u, 0x180116b0u, 0x000800c6u, 0x060112aeu,
+    0x00610aaau, 0x60011ab2u, 0x000400a5u, 0x030110adu, 0x003108a9u, 0x300118b1u,
+    0x000d04a7u, 0x0c0114afu, 0x00c10cabu, 0x00000000u, 0x000100a5u, 0x01010eacu,
+    0x001106a8u, 0x100116b0u, 0x000500c6u, 0x040112aeu, 0x00410aaau, 0x40011ab2u,
+    0x000300a5u, 0x020110adu, 0x002108a9u, 0x200118b1u, 0x000904a7u, 0x080114afu,
+    0x00810cabu, 0x00000000u, 0x000200a5u, 0x01810eacu, 0x001906a8u, 0x180116b0u,
+    0x000700c6u, 0x060112aeu, 0x00610aaau, 0x60011ab2u, 0x000400a5u, 0x030110adu,
+    0x003108a9u, 0x300118b1u, 0x000d04a7u, 0x0c0114afu, 0x00c10cabu, 0x00000000u,
+    0x000100a5u, 0x01010eacu, 0x001106a8u, 0x100116b0u, 0x000600c6u, 0x040112aeu,
+    0x00410aaau, 0x40011ab2u, 0x000300a5u, 0x020110adu, 0x002108a9u, 0x200118b1u,
+    0x000904a7u, 0x080114afu, 0x00810cabu, 0x00000000u, 0x000200a5u, 0x01810eacu,
+    0x001906a8u, 0x180116b0u, 0x000800c6u, 0x060112aeu, 0x00610aaau, 0x60011ab2u,
+    0x000400a5u, 0x030110adu, 0x003108a9u, 0x300118b1u, 0x000d04a7u, 0x0c0114afu,
+    0x00c10cabu, 0x00000000u, 0x000100a5u, 0x01010eacu, 0x001106a8u, 0x100116b0u,
+    0x000500c6u, 0x040112aeu, 0x00410aaau, 0x40011ab2u, 0x000300a5u, 0x020110adu,
+    0x002108a9u, 0x200118b1u, 0x000904a7u, 0x080114afu, 0x00810cabu, 0x00000000u,
+    0x000200a5u, 0x01810eacu, 0x001906a8u, 0x180116b0u, 0x000700c6u, 0x060112aeu,
+    0x00610aaau, 0x60011ab2u, 0x000400a5u, 0x030110adu, 0x003108a9u, 0x300118b1u,
+    0x000d04a7u, 0x0c0114afu, 0x00c10cabu, 0x00000000u, 0x000100a5u, 0x01010eacu,
+    0x001106a8u, 0x100116b0u, 0x000600c6u, 0x040112aeu, 0x00410aaau, 0x40011ab2u,
+    0x000300a5u, 0x020110adu, 0x002108a9u, 0x200118b1u, 0x000904a7u, 0x080114afu,
+    0x00810cabu, 0x00000000u, 0x000200a5u, 0x01810eacu, 0x001906a8u, 0x180116b0u,
+    0x000800c6u, 0x060112aeu, 0x00610aaau, 0x60011ab2u, 0x000400a5u, 0x030110adu,
+    0x003108a9u, 0x300118b1u, 0x000d04a7u, 0x0c0114afu, 0x00c10cabu, 0x00000000u,
+    0x000100a5u, 0x01010eacu, 0x001106a8u, 0x100116b0u, 0x000500c6u, 0x040112aeu,
+    0x00410aaau, 0x40011ab2u, 0x000300a5u, 0x020110adu, 0x002108a9u, 0x200118b1u,
+    0x000904a7u, 0x080114afu, 0x00810cabu, 0x00000000u, 0x000200a5u, 0x01810eacu,
+    0x001906a8u, 0x180116b0u, 0x000700c6u, 0x060112aeu, 0x00610aaau, 0x60011ab2u,
+    0x000400a5u, 0x030110adu, 0x003108a9u, 0x300118b1u, 0x000d04a7u, 0x0c0114afu,
+    0x00c10cabu, 0x00000000u, 0x000100a5u, 0x01010eacu, 0x001106a8u, 0x100116b0u,
+    0x000600c6u, 0x040112aeu, 0x00410aaau, 0x40011ab2u, 0x000300a5u, 0x020110adu,
+    0x002108a9u, 0x200118b1u, 0x000904a7u, 0x080114afu, 0x00810cabu, 0x00000000u,
+    0x000200a5u, 0x01810eacu, 0x001906a8u, 0x180116b0u, 0x000800c6u, 0x060112aeu,
+    0x00610aaau, 0x60011ab2u, 0x000400a5u, 0x030110adu, 0x003108a9u, 0x300118b1u,
+    0x000d04a7u, 0x0c0114afu, 0x00c10cabu, 0x00000000u
+  },
+  256
+};
@@ -0,0 +1,1065 @@
+/*
+ * Copyright (C) 2025 Recep Aslantas
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ft.h"
+
+UNZ_INLINE uint16_t
+infl_ft_rev16(uint16_t v, unsigned len) {
+  v = (uint16_t)(((v & 0x5555u) << 1) | ((v >> 1) & 0x5555u));
+  v = (uint16_t)(((v & 0x3333u) << 2) | ((v >> 2) & 0x3333u));
+  v = (uint16_t)(((v & 0x0f0fu) << 4) | ((v >> 4) & 0x0f0fu));
+  v = (uint16_t)((v << 8) | (v >> 8));
+  return (uint16_t)(v >> (16u - len));
+}
+
+UNZ_INLINE uint32_t
+infl_ft_lit_entry(unsigned sym, unsigned len) {
+  if (sym < 256)
+    return INFL_FT_ENTRY(sym, 0, len, INFL_FT_LITERAL);
+
+  if (sym == 256)
+    return INFL_FT_ENTRY(0, 0, len, INFL_FT_END);
+
+  if (sym <= 285) {
+    huff_ext_t ext = lvals[sym - 257];
+    return INFL_FT_ENTRY(ext.base, ext.bits, len, 0);
+  }
+
+  return 0;
+}
+
+UNZ_INLINE uint32_t
+infl_ft_dist_entry(unsigned sym, unsigned len) {
+  huff_ext_t ext;
+
+  if (unlikely(sym > 29))
+    return 0;
+
+  ext = dvals[sym];
+  return INFL_FT_ENTRY(ext.base, ext.bits, len, 0);
+}
+
+UNZ_INLINE unsigned
+infl_ft_sym_xbits(unsigned sym, bool litlen, huff_ext_t *ext) {
+  if (litlen) {
+    if (sym < 257 || sym > 285)
+      return 0;
+    *ext = lvals[sym - 257];
+  } else {
+    if (sym > 29)
+      return 0;
+    *ext = dvals[sym];
+  }
+  return ext->bits;
+}
+
+UNZ_INLINE uint32_t
+infl_ft_sym_entry(unsigned sym, unsigned len, bool litlen) {
+  return litlen ? infl_ft_lit_entry(sym, len) : infl_ft_dist_entry(sym, len);
+}
+
+/*
+ * symbols are counting-sorted by code length, so canonical codes come out in
+ * order and each one is stored once: the main table starts at the shortest
+ * length and is doubled with memcpy before the next length is placed, which
+ * replicates every shorter code into the new upper half. only the first
+ * 2^minlen entries are cleared, for the gaps of an incomplete code. codes
+ * longer than the main table follow, grouped by prefix, into subtables
+ */
+UNZ_HIDE
+bool
+infl_ft_build(uint32_t      * __restrict table,
+              uint16_t      * __restrict used_out,
+              const uint8_t * __restrict lens,
+              uint16_t                   nsyms,
+              unsigned                   tablebits,
+              unsigned                   cap,
+              bool                       litlen) {
+  uint16_t hist[4][HUFF_MAX_CODE_LENGTH + 1] = {{0}};
+  unsigned count[HUFF_MAX_CODE_LENGTH + 1];
+  unsigned offs[HUFF_MAX_CODE_LENGTH + 1];
+  uint16_t sorted[MAX_LITLEN_CODES], revs[MAX_LITLEN_CODES];
+  unsigned main_size, used, maxbits, buildbits, sizebits, widest, minlen;
+  unsigned len, code, sym, i, n, nshort, any;
+  int      left;
+
+  maxbits = 15;
+  any     = 0;
+
+  if (unlikely(tablebits > INFL_FT_LIT_BITS || (1u << tablebits) > cap
+               || nsyms > MAX_LITLEN_CODES))
+    return false;
+
+  /* four histograms, runs of equal lengths (mostly zeros) would otherwise
+     serialize on one counter. a length over 15 sets a bit in any */
+  for (sym = 0; sym + 4u <= nsyms; sym += 4u) {
+    any |= lens[sym] | lens[sym + 1] | lens[sym + 2] | lens[sym + 3];
+    hist[0][lens[sym]     & 15u]++;
+    hist[1][lens[sym + 1] & 15u]++;
+    hist[2][lens[sym + 2] & 15u]++;
+    hist[3][lens[sym + 3] & 15u]++;
+  }
+  for (; sym < nsyms; sym++) {
+    any |= lens[sym];
+    hist[0][lens[sym] & 15u]++;
+  }
+
+  if (unlikely(any > maxbits))
+    return false;
+
+  for (len = 0; len <= maxbits; len++)
+    count[len] = hist[0][len] + hist[1][len] + hist[2][len] + hist[3][len];
+
+  left = 1;
+  for (len = 1; len <= maxbits; len++) {
+    left = (left << 1) - (int)count[len];
+    if (unlikely(left < 0))
+      return false;
+  }
+
+  n = 0;
+  for (len = 1; len <= maxbits; len++) {
+    offs[len] = n;
+    n        += count[len];
+  }
+
+  if (unlikely(!n)) {
+    memset(table, 0, (1u << tablebits) * sizeof(table[0]));
+    *used_out = (uint16_t)(1u << tablebits);
+    return true;
+  }
+
+  for (sym = 0; sym < nsyms; sym++) {
+    if (lens[sym])
+      sorted[offs[lens[sym]]++] = (uint16_t)sym;
+  }
+
+  minlen = 1;
+  while (!count[minlen])
+    minlen++;
+  widest = maxbits;
+  while (!count[widest])
+    widest--;
+
+  /* short codes only: build a narrower main table and double it up to
+     tablebits, the index bits above its width select nothing. lit/len keeps
+     three more bits so the longest code still pairs with the short ones */
+  buildbits = tablebits;
+  while (buildbits > INFL_FT_BUILD_MIN
+         && buildbits > widest + ((litlen && INFL_FT_LITPAIRS) ? 3u : 0u))
+    buildbits--;
+
+  /* bit-reversed canonical code of every symbol, in sorted order */
+  code = 0;
+  for (i = 0, len = minlen; len <= widest; len++, code <<= 1) {
+    for (unsigned k = count[len]; k; k--, code++, i++)
+      revs[i] = infl_ft_rev16((uint16_t)code, len);
+  }
+
+  sizebits  = minlen < buildbits ? minlen : buildbits;
+  main_size = 1u << sizebits;
+  memset(table, 0, main_size * sizeof(table[0]));
+
+  for (i = 0, len = minlen; len <= widest && len <= buildbits; len++) {
+    if (!count[len])
+      continue;
+
+    for (; sizebits < len; sizebits++, main_size <<= 1)
+      memcpy(table + main_size, table, main_size * sizeof(table[0]));
+
+    for (unsigned k = count[len]; k; k--, i++)
+      table[revs[i]] = infl_ft_sym_entry(sorted[i], len, litlen);
+  }
+
+  for (; sizebits < buildbits; sizebits++, main_size <<= 1)
+    memcpy(table + main_size, table, main_size * sizeof(table[0]));
+
+  used   = main_size;
+  nshort = i;
+
+#if INFL_FT_PREXBITS
+  /* extra bits sit right above the code, so value e of a code is at every
+     index whose low bits are the code followed by e. these entries have no
+     extra bits left and CODELEN == TOTAL, the usual decode adds nothing */
+  for (i = 0; i < nshort; i++) {
+    huff_ext_t ext;
+    unsigned   x, step;
+
+    sym = sorted[i];
+    len = lens[sym];
+    if (!(x = infl_ft_sym_xbits(sym, litlen, &ext)) || len + x > buildbits)
+      continue;
+
+    step = 1u << (len + x);
+    for (unsigned e = 0; e < (1u << x); e++) {
+      uint32_t entry;
+
+      entry = INFL_FT_ENTRY(ext.base + e, 0, len + x, 0);
+      for (unsigned idx = revs[i] | (e << len); idx < main_size; idx += step)
+        table[idx] = entry;
+    }
+  }
+#endif
+
+  /* left-aligned canonical codes increase, so codes longer than the main
+     table that share a prefix are adjacent and the last of them is longest */
+  for (unsigned j = nshort, k; j < n; j = k) {
+    unsigned prefix, subbits, size, fill, maxlen;
+
+    prefix = revs[j] & (main_size - 1u);
+    for (k = j + 1; k < n && (revs[k] & (main_size - 1u)) == prefix; k++)
+      ;
+
+    maxlen  = lens[sorted[k - 1]];
+    subbits = maxlen - buildbits;
+    size    = 1u << subbits;
+    if (unlikely(used + size > cap))
+      return false;
+
+    fill = 0;
+    for (unsigned c = j; c < k; c++)
+      fill += 1u << (maxlen - lens[sorted[c]]);
+    if (fill != size)
+      memset(table + used, 0, size * sizeof(table[0]));
+
+    table[prefix] = INFL_FT_SUBENTRY(used, subbits, buildbits);
+    for (unsigned c = j; c < k; c++) {
+      uint32_t entry;
+      unsigned step;
+
+      len   = lens[sorted[c]];
+      entry = infl_ft_sym_entry(sorted[c], len, litlen);
+      step  = 1u << (len - buildbits);
+      for (unsigned idx = revs[c] >> buildbits; idx < size; idx += step)
+        table[used + idx] = entry;
+    }
+
+    used += size;
+  }
+
+#if INFL_FT_LITPAIRS
+  /* a short literal followed by a literal that fits in the rest of the index
+     becomes one entry. pairs are written from the sorted codes, every index
+     whose low bits are the two codes */
+  if (litlen) {
+    for (unsigned a = 0; a < nshort; a++) {
+      unsigned len1, sym1;
+
+      sym1 = sorted[a];
+      len1 = lens[sym1];
+      if (len1 + minlen > buildbits)
+        break;
+      if (sym1 > 255)
+        continue;
+
+      for (unsigned b = 0; b < nshort; b++) {
+        uint32_t entry;
+        unsigned sym2, len2, step;
+
+        sym2 = sorted[b];
+        len2 = lens[sym2];
+        if (len1 + len2 > buildbits)
+          break;
+        if (sym2 > 255)
+          continue;
+
+        entry = INFL_FT_PAIR(sym1, sym2, len1, len2);
+        step  = 1u << (len1 + len2);
+        for (unsigned idx = revs[a] | (revs[b] << len1); idx < main_size; idx += step)
+          table[idx] = entry;
+      }
+    }
+  }
+#endif
+
+  for (; main_size < (1u << tablebits); main_size <<= 1, used <<= 1)
+    memcpy(table + main_size, table, main_size * sizeof(table[0]));
+
+  *used_out = (uint16_t)used;
+  return true;
+}
+
+UNZ_HIDE
+bool
+infl_ft_tables(infl_ft_table_t      * __restrict tlit,
+               infl_ft_dist_table_t * __restrict tdist,
+               const uint8_t        * __restrict lens,
+               unsigned                          hlit,
+               unsigned                          hdist) {
+  return infl_ft_build(tlit->table, &tlit->used, lens, (uint16_t)hlit,
+                       INFL_FT_LIT_BITS, INFL_FT_LIT_CAP, true) &&
+         infl_ft_build(tdist->table, &tdist->used, lens + hlit, (uint16_t)hdist,
+                       INFL_FT_DIST_BITS, INFL_FT_DIST_CAP, false);
+}
+
+static uint32_t
+infl_ft_lens_hash(const uint8_t * __restrict lens, unsigned n) {
+  uint64_t h, w;
+  unsigned i;
+
+  h = n;
+  for (i = 0; i + 8u <= n; i += 8u)
+    h = (h ^ infl_load64(lens + i)) * UINT64_C(0x9E3779B97F4A7C15);
+
+  w = 0;
+  memcpy(&w, lens + i, n - i);
+  h = (h ^ w) * UINT64_C(0x9E3779B97F4A7C15);
+  return (uint32_t)(h >> 32);
+}
+
+UNZ_HIDE
+const infl_ft_dyn_t *
+infl_ft_dyn_tables(defl_stream_t * __restrict stream,
+                   const uint8_t * __restrict lens,
+                   unsigned                   hlit,
+                   unsigned                   hdist) {
+  infl_ft_cache_t *cache;
+  infl_ft_dyn_t   *ent;
+  uint32_t         hash;
+  unsigned         n, i;
+
+  n    = hlit + hdist;
+  hash = infl_ft_lens_hash(lens, n);
+
+  if ((ent = stream->ftone)) {
+    /* infl_once(): a single slot on the caller's stack */
+    if (ent->hash == hash && ent->n == n && ent->hlit == hlit
+        && !memcmp(ent->lens, lens, n)) {
+#ifdef UNZ_STATS
+      stream->table_cache_hits++;
+#endif
+      return ent;
+    }
+  } else {
+    if (unlikely(!(cache = infl_ft_cache(stream))))
+      return NULL;
+
+    for (i = 0; i < INFL_FT_CACHE_SIZE; i++) {
+      ent = &cache->ent[i];
+      if (ent->hash == hash && ent->n == n && ent->hlit == hlit
+          && !memcmp(ent->lens, lens, n)) {
+#ifdef UNZ_STATS
+        stream->table_cache_hits++;
+#endif
+        return ent;
+      }
+    }
+
+    ent         = &cache->ent[cache->next];
+    cache->next = (cache->next + 1u) % INFL_FT_CACHE_SIZE;
+  }
+  ent->n = 0;
+
+#ifdef UNZ_STATS
+  {
+    uint64_t t0;
+    bool     ok;
+
+    stream->table_cache_misses++;
+    t0 = infl_ft_cycles();
+    ok = infl_ft_tables(&ent->tlit, &ent->tdist, lens, hlit, hdist);
+    stream->table_build_cycles += infl_ft_cycles() - t0;
+    if (unlikely(!ok))
+      return NULL;
+  }
+#else
+  if (unlikely(!infl_ft_tables(&ent->tlit, &ent->tdist, lens, hlit, hdist)))
+    return NULL;
+#endif
+
+  memcpy(ent->lens, lens, n);
+  ent->hash = hash;
+  ent->hlit = (uint16_t)hlit;
+  ent->n    = (uint16_t)n;
+  return ent;
+}
+
+#include "fixed.h"
+
+#ifdef INFL_MAKEFIXED
+/*
+ * writes fixed.h to out. to regenerate it after changing the entry layout or
+ * the table widths, build ft.c with -DINFL_MAKEFIXED and call this once
+ */
+static void
+infl_ft_makefixed_table(FILE           * __restrict out,
+                        const char     * __restrict type,
+                        const char     * __restrict name,
+                        const uint32_t * __restrict table,
+                        unsigned                    used) {
+  unsigned i;
+
+  fprintf(out, "UNZ_HIDE const %s %s = {\n  {", type, name);
+  for (i = 0; i < used; i++)
+    fprintf(out, "%s0x%08xu%s", (i % 6u) ? " " : "\n    ", (unsigned)table[i],
+            i + 1 < used ? "," : "");
+  fprintf(out, "\n  },\n  %u\n};\n", used);
+}
+
+UNZ_HIDE
+int
+infl_ft_makefixed(FILE * __restrict out) {
+  static infl_ft_table_t      tlit;
+  static infl_ft_dist_table_t tdist;
+
+  if (!infl_ft_tables(&tlit, &tdist, fxd, 288, 32))
+    return UNZ_ERR;
+
+  fprintf(out,
+          "/* fixed.h -- fixed huffman decode tables for INFL_FT_LIT_BITS %u and\n"
+          " * INFL_FT_DIST_BITS %u, generated by infl_ft_makefixed() in ft.c\n"
+          " */\n\n"
+          "#if INFL_FT_LIT_BITS != %uu || INFL_FT_DIST_BITS != %uu\n"
+          "#  error \"fixed.h is stale, regenerate it with infl_ft_makefixed()\"\n"
+          "#endif\n\n",
+          INFL_FT_LIT_BITS, INFL_FT_DIST_BITS, INFL_FT_LIT_BITS, INFL_FT_DIST_BITS);
+
+  infl_ft_makefixed_table(out, "infl_ft_table_t", "infl_ft_fixed_lit",
+                          tlit.table, tlit.used);
+  fprintf(out, "\n");
+  infl_ft_makefixed_table(out, "infl_ft_dist_table_t", "infl_ft_fixed_dist",
+                          tdist.table, tdist.used);
+  return UNZ_OK;
+}
+#endif
+
+UNZ_HIDE
+void
+infl_ft_unstitch(infl_ft_bits_t * __restrict br) {
+  unz_chunk_t   *ch;
+  const uint8_t *q;
+  size_t         k, avail;
+
+  if (!br->sp)
+    return;
+
+  /* walk the chain from stitch[0] by the bytes already taken from the buffer */
+  ch = br->chunk;
+  q  = br->sp;
+  k  = (size_t)(br->p - br->stitch);
+  for (;;) {
+    avail = (q && q < ch->end) ? (size_t)(ch->end - q) : 0;
+    if (k < avail || !ch->next)
+      break;
+    k  -= avail;
+    ch  = ch->next;
+    q   = ch->p;
+  }
+
+  br->chunk = ch;
+  br->p     = q + k;
+  br->end   = ch->end;
+  br->sp    = NULL;
+  br->lim   = NULL;
+}
+
+UNZ_HIDE
+bool
+infl_ft_next_chunk(infl_ft_bits_t * __restrict br) {
+  unz_chunk_t   *ch;
+  const uint8_t *q;
+  size_t         n, take;
+
+  /* the padding is all there is past a padded tail */
+  if (br->lim)
+    return false;
+
+  infl_ft_unstitch(br);
+
+  ch = br->chunk;
+  q  = br->p;
+  if (!ch)
+    return br->p < br->end;
+
+  /* the last bytes of complete input go to stitch with zeros behind them, so
+     the refills keep doing whole-word loads to the end. reading past lim is
+     settled by infl_ft_settle() once the block is done */
+  if (br->pad && !ch->next && (size_t)(ch->end - q) < sizeof(uint64_t)) {
+    n = q < ch->end ? (size_t)(ch->end - q) : 0;
+    memcpy(br->stitch, q, n);
+    memset(br->stitch + n, 0, INFL_FT_STITCH - n);
+
+    br->sp  = q;
+    br->p   = br->stitch;
+    br->lim = br->stitch + n;
+    br->end = br->stitch + INFL_FT_STITCH;
+    return true;
+  }
+
+  /* enough left to read in place, or nothing follows to stitch with */
+  if ((size_t)(ch->end - q) >= INFL_FT_STITCH / 2 || !ch->next)
+    return br->p < br->end;
+
+  n = 0;
+  for (;;) {
+    if (q && q < ch->end) {
+      take = (size_t)(ch->end - q);
+      if (take > INFL_FT_STITCH - n)
+        take = INFL_FT_STITCH - n;
+      memcpy(br->stitch + n, q, take);
+      n += take;
+      if (n == INFL_FT_STITCH)
+        break;
+    }
+    if (!(ch = ch->next))
+      break;
+    q = ch->p;
+  }
+
+  /* the whole remaining input is this chunk's tail, keep reading it in place */
+  if (n == (size_t)(br->end - br->p))
+    return n != 0;
+
+  br->sp  = br->p;
+  br->p   = br->stitch;
+  br->end = br->stitch + n;
+  return true;
+}
+
+UNZ_HIDE
+UnzResult
+infl_ft_stored(infl_ft_bits_t * __restrict br,
+               uint8_t        * __restrict dst,
+               size_t         * __restrict dpos,
+               size_t                      dst_cap,
+               bool                        nocache) {
+  uint32_t header;
+  uint16_t len, nlen;
+  unsigned nbytes, shift;
+  size_t   rem;
+
+  shift = br->nbits & 7u;
+  if (shift)
+    infl_ft_consume(br, shift);
+
+  infl_ft_refill(br, 32);
+  if (unlikely(br->nbits < 32))
+    return UNZ_ERR;
+
+  header = (uint32_t)br->bits;
+  infl_ft_consume(br, 32);
+
+  len  = (uint16_t)header;
+  nlen = (uint16_t)(header >> 16);
+  if (unlikely((uint16_t)(len ^ (uint16_t)~nlen)))
+    return UNZ_ERR;
+  if (unlikely(len > dst_cap - *dpos))
+    return UNZ_EFULL;
+
+  /* the copy below reads p..end directly, never the padding */
+  if (br->lim) {
+    if (unlikely(!infl_ft_settle(br)))
+      return UNZ_ERR;
+    infl_ft_unstitch(br);
+  }
+
+  rem    = len;
+  nbytes = br->nbits >> 3;
+  if (nbytes > rem)
+    nbytes = (unsigned)rem;
+
+  if (nbytes) {
+    switch (nbytes) {
+      case 7: dst[*dpos + 6] = (uint8_t)(br->bits >> 48); /* fall through */
+      case 6: dst[*dpos + 5] = (uint8_t)(br->bits >> 40); /* fall through */
+      case 5: dst[*dpos + 4] = (uint8_t)(br->bits >> 32); /* fall through */
+      case 4: dst[*dpos + 3] = (uint8_t)(br->bits >> 24); /* fall through */
+      case 3: dst[*dpos + 2] = (uint8_t)(br->bits >> 16); /* fall through */
+      case 2: dst[*dpos + 1] = (uint8_t)(br->bits >> 8);  /* fall through */
+      case 1: dst[*dpos]     = (uint8_t)br->bits;         /* fall through */
+      default: break;
+    }
+    infl_ft_consume(br, nbytes << 3);
+    *dpos += nbytes;
+    rem   -= nbytes;
+  }
+
+  while (rem) {
+    size_t n;
+
+    if (unlikely(br->p >= br->end) && !infl_ft_next_chunk(br))
+      return UNZ_ERR;
+
+    n = (size_t)(br->end - br->p);
+    if (n > rem)
+      n = rem;
+
+    if (nocache)
+      infl_copy_nocache(dst + *dpos, br->p, n);
+    else
+      memcpy(dst + *dpos, br->p, n);
+    br->p += n;
+    *dpos += n;
+    rem   -= n;
+  }
+
+  return UNZ_OK;
+}
+
+/* baseline loop, built with the library's own flags */
+#define INFL_FT_FN(NAME)    NAME##_generic
+#define INFL_FT_TARGET
+#define INFL_FT_COPY_MATCH  infl_copy_match_overrun
+#define INFL_FT_COPY_RLE    infl_copy_rle_overrun
+#define INFL_FT_COPY_SMALL  infl_copy_match_small_overrun
+#define INFL_FT_SLACK       INFL_FT_SLACK_WORD
+#include "ft_loop.h"
+#undef INFL_FT_FN
+#undef INFL_FT_TARGET
+#undef INFL_FT_COPY_MATCH
+#undef INFL_FT_COPY_RLE
+#undef INFL_FT_COPY_SMALL
+#undef INFL_FT_SLACK
+
+#if INFL_FT_DISPATCH
+#include <immintrin.h>
+
+/* same loop, EXTRACT and consume lower to bzhi/shrx */
+#define INFL_FT_FN(NAME)    NAME##_bmi2
+#define INFL_FT_TARGET      __attribute__((target("bmi,bmi2")))
+#define INFL_FT_COPY_MATCH  infl_copy_match_overrun
+#define INFL_FT_COPY_RLE    infl_copy_rle_overrun
+#define INFL_FT_COPY_SMALL  infl_copy_match_small_overrun
+#define INFL_FT_SLACK       INFL_FT_SLACK_WORD
+#include "ft_loop.h"
+#undef INFL_FT_FN
+#undef INFL_FT_TARGET
+#undef INFL_FT_COPY_MATCH
+#undef INFL_FT_COPY_RLE
+#undef INFL_FT_COPY_SMALL
+#undef INFL_FT_SLACK
+
+/* dist >= 32 moves 32 bytes per step, shorter distances keep the word kernel.
+   both overruns fit the 40-byte word slack */
+UNZ_INLINE __attribute__((target("avx2"))) void
+infl_copy_match_avx2(uint8_t * __restrict dst,
+                     size_t  * __restrict dpos,
+                     unsigned             dist,
+                     unsigned             len) {
+  const uint8_t *src;
+  size_t         pos, end;
+
+  if (dist < 32) {
+    infl_copy_match_overrun(dst, dpos, dist, len);
+    return;
+  }
+
+  pos = *dpos;
+  src = dst + pos - dist;
+  end = pos + len;
+
+  do {
+    _mm256_storeu_si256((__m256i *)(dst + pos),
+                        _mm256_loadu_si256((const __m256i *)src));
+    src += 32;
+    pos += 32;
+  } while (pos < end);
+
+  *dpos = end;
+}
+
+UNZ_INLINE __attribute__((target("avx2"))) void
+infl_copy_rle_avx2(uint8_t * __restrict dst, size_t * __restrict dpos, unsigned len) {
+  __m256i v;
+  size_t  pos, end;
+
+  pos = *dpos;
+  v   = _mm256_set1_epi8((char)dst[pos - 1]);
+  end = pos + len;
+
+  do {
+    _mm256_storeu_si256((__m256i *)(dst + pos), v);
+    pos += 32;
+  } while (pos < end);
+
+  *dpos = end;
+}
+
+/* pshufb indices repeating the first dist bytes across 32 bytes, and the
+   largest multiple of dist that fits in 32, for dist 2..7 */
+static UNZ_ALIGN(32) const uint8_t infl_pattern_shuf[8][32] = {
+  {0},
+  {0},
+  {0,1,0,1,0,1,0,1,0,1,0,1,0,1,0,1, 0,1,0,1,0,1,0,1,0,1,0,1,0,1,0,1},
+  {0,1,2,0,1,2,0,1,2,0,1,2,0,1,2,0, 1,2,0,1,2,0,1,2,0,1,2,0,1,2,0,1},
+  {0,1,2,3,0,1,2,3,0,1,2,3,0,1,2,3, 0,1,2,3,0,1,2,3,0,1,2,3,0,1,2,3},
+  {0,1,2,3,4,0,1,2,3,4,0,1,2,3,4,0, 1,2,3,4,0,1,2,3,4,0,1,2,3,4,0,1},
+  {0,1,2,3,4,5,0,1,2,3,4,5,0,1,2,3, 4,5,0,1,2,3,4,5,0,1,2,3,4,5,0,1},
+  {0,1,2,3,4,5,6,0,1,2,3,4,5,6,0,1, 2,3,4,5,6,0,1,2,3,4,5,6,0,1,2,3}
+};
+static const uint8_t infl_pattern_step[8] = {0, 32, 32, 30, 32, 30, 30, 28};
+
+/* dist 2..7: one shuffle builds a 32-byte period-aligned pattern, then each
+   store writes it whole. overrun stays below 32 bytes */
+UNZ_INLINE __attribute__((target("avx2"))) void
+infl_copy_match_small_avx2(uint8_t * __restrict dst,
+                           size_t  * __restrict dpos,
+                           unsigned             dist,
+                           unsigned             len) {
+  __m256i pat;
+  size_t  pos, end, step;
+
+  pos  = *dpos;
+  end  = pos + len;
+  step = infl_pattern_step[dist];
+  pat  = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)(dst + pos - dist)));
+  pat  = _mm256_shuffle_epi8(pat, _mm256_load_si256((const __m256i *)infl_pattern_shuf[dist]));
+
+  do {
+    _mm256_storeu_si256((__m256i *)(dst + pos), pat);
+    pos += step;
+  } while (pos < end);
+
+  *dpos = end;
+}
+
+#define INFL_FT_FN(NAME)    NAME##_avx2
+#define INFL_FT_TARGET      __attribute__((target("avx2,bmi,bmi2")))
+#define INFL_FT_COPY_MATCH  infl_copy_match_avx2
+#define INFL_FT_COPY_RLE    infl_copy_rle_avx2
+#define INFL_FT_COPY_SMALL  infl_copy_match_small_avx2
+#define INFL_FT_SLACK       INFL_FT_SLACK_WORD
+#include "ft_loop.h"
+#undef INFL_FT_FN
+#undef INFL_FT_TARGET
+#undef INFL_FT_COPY_MATCH
+#undef INFL_FT_COPY_RLE
+#undef INFL_FT_COPY_SMALL
+#undef INFL_FT_SLACK
+
+/* dist >= 64 moves a whole zmm per step, the loop reserves 64 bytes of slack */
+UNZ_INLINE __attribute__((target("avx512f,avx512bw"))) void
+infl_copy_match_avx512(uint8_t * __restrict dst,
+                       size_t  * __restrict dpos,
+                       unsigned             dist,
+                       unsigned             len) {
+  const uint8_t *src;
+  size_t         pos, end;
+
+  if (dist < 64) {
+    infl_copy_match_avx2(dst, dpos, dist, len);
+    return;
+  }
+
+  pos = *dpos;
+  src = dst + pos - dist;
+  end = pos + len;
+
+  do {
+    _mm512_storeu_si512((void *)(dst + pos), _mm512_loadu_si512((const void *)src));
+    src += 64;
+    pos += 64;
+  } while (pos < end);
+
+  *dpos = end;
+}
+
+UNZ_INLINE __attribute__((target("avx512f,avx512bw"))) void
+infl_copy_rle_avx512(uint8_t * __restrict dst, size_t * __restrict dpos, unsigned len) {
+  __m512i v;
+  size_t  pos, end;
+
+  pos = *dpos;
+  v   = _mm512_set1_epi8((char)dst[pos - 1]);
+  end = pos + len;
+
+  do {
+    _mm512_storeu_si512((void *)(dst + pos), v);
+    pos += 64;
+  } while (pos < end);
+
+  *dpos = end;
+}
+
+#define INFL_FT_FN(NAME)    NAME##_avx512
+#define INFL_FT_TARGET      __attribute__((target("avx512f,avx512bw,avx2,bmi,bmi2")))
+#define INFL_FT_COPY_MATCH  infl_copy_match_avx512
+#define INFL_FT_COPY_RLE    infl_copy_rle_avx512
+#define INFL_FT_COPY_SMALL  infl_copy_match_small_avx2
+#define INFL_FT_SLACK       INFL_FT_SLACK_MAX
+#include "ft_loop.h"
+#undef INFL_FT_FN
+#undef INFL_FT_TARGET
+#undef INFL_FT_COPY_MATCH
+#undef INFL_FT_COPY_RLE
+#undef INFL_FT_COPY_SMALL
+#undef INFL_FT_SLACK
+#endif
+
+typedef UnzResult (*infl_ft_loop_fn)(infl_ft_bits_t             * __restrict br,
+                                     uint8_t                    * __restrict dst,
+                                     size_t                     * __restrict dpos,
+                                     size_t                                  dst_cap,
+                                     const infl_ft_table_t      * __restrict tlit,
+                                     const infl_ft_dist_table_t * __restrict tdist);
+
+typedef struct infl_ft_impl_t {
+  const char      *name;
+  infl_ft_loop_fn  block;
+  infl_ft_loop_fn  fast;
+} infl_ft_impl_t;
+
+/* ordered by required cpu features, each level implies the previous ones */
+static const infl_ft_impl_t infl_ft_impls[] = {
+  {"generic", infl_ft_block_generic, infl_ft_fast_generic},
+#if INFL_FT_DISPATCH
+  {"bmi2",    infl_ft_block_bmi2,    infl_ft_fast_bmi2},
+  {"avx2",    infl_ft_block_avx2,    infl_ft_fast_avx2},
+  {"avx512",  infl_ft_block_avx512,  infl_ft_fast_avx512},
+#endif
+};
+
+#if INFL_FT_DISPATCH
+static const infl_ft_impl_t *infl_ft_impl_cur;
+
+static const infl_ft_impl_t *
+infl_ft_impl_select(void) {
+  const infl_ft_impl_t *impl;
+  const char           *cap;
+  size_t                lvl, i;
+
+  __builtin_cpu_init();
+
+  lvl = 0;
+  if (__builtin_cpu_supports("bmi2")) {
+    lvl = 1;
+    if (__builtin_cpu_supports("avx2")) {
+      lvl = 2;
+      if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw"))
+        lvl = 3;
+    }
+  }
+
+  /* DEFL_CPU=generic|bmi2|avx2|avx512 caps the level, to compare or test variants */
+  if ((cap = getenv("DEFL_CPU"))) {
+    for (i = 0; i < ARRAY_LEN(infl_ft_impls); i++) {
+      if (!strcmp(cap, infl_ft_impls[i].name)) {
+        if (i < lvl)
+          lvl = i;
+        break;
+      }
+    }
+  }
+
+  /* every thread resolves to the same pointer, a racing store is harmless */
+  impl = &infl_ft_impls[lvl];
+  __atomic_store_n(&infl_ft_impl_cur, impl, __ATOMIC_RELAXED);
+  return impl;
+}
+
+UNZ_INLINE const infl_ft_impl_t *
+infl_ft_impl(void) {
+  const infl_ft_impl_t *impl;
+
+  impl = __atomic_load_n(&infl_ft_impl_cur, __ATOMIC_RELAXED);
+  if (unlikely(!impl))
+    impl = infl_ft_impl_select();
+  return impl;
+}
+#else
+UNZ_INLINE const infl_ft_impl_t *
+infl_ft_impl(void) {
+  return &infl_ft_impls[0];
+}
+#endif
+
+#if INFL_FT_DISPATCH || defined(__CLFLUSHOPT__)
+#  if INFL_FT_DISPATCH
+#    include <cpuid.h>
+#    define INFL_FLUSH_TARGET __attribute__((target("clflushopt")))
+#  else
+#    define INFL_FLUSH_TARGET
+#  endif
+
+static INFL_FLUSH_TARGET void
+infl_flush_lines_clflushopt(const uint8_t * __restrict dst, size_t from, size_t to) {
+  size_t pos;
+
+  for (pos = from; pos < to; pos += CACHE_LINE_SIZE)
+    _mm_clflushopt((void *)(dst + pos));
+  _mm_sfence();
+}
+#endif
+
+#if defined(__CLFLUSHOPT__)
+UNZ_HIDE
+void
+infl_flush_lines(const uint8_t * __restrict dst, size_t from, size_t to) {
+  infl_flush_lines_clflushopt(dst, from, to);
+}
+#elif INFL_FT_DISPATCH
+typedef void (*infl_flush_fn)(const uint8_t * __restrict dst, size_t from, size_t to);
+
+static void
+infl_flush_lines_none(const uint8_t * __restrict dst, size_t from, size_t to) {
+  (void)dst;
+  (void)from;
+  (void)to;
+}
+
+static infl_flush_fn infl_flush_cur;
+
+static infl_flush_fn
+infl_flush_select(void) {
+  infl_flush_fn fn;
+  unsigned      a, b, c, d;
+
+  /* leaf 7 ebx bit 23 */
+  fn = infl_flush_lines_none;
+  if (__get_cpuid_count(7, 0, &a, &b, &c, &d) && (b & (1u << 23)))
+    fn = infl_flush_lines_clflushopt;
+
+  /* same as infl_ft_impl_select(), a racing store is harmless */
+  __atomic_store_n(&infl_flush_cur, fn, __ATOMIC_RELAXED);
+  return fn;
+}
+
+UNZ_HIDE
+void
+infl_flush_lines(const uint8_t * __restrict dst, size_t from, size_t to) {
+  infl_flush_fn fn;
+
+  fn = __atomic_load_n(&infl_flush_cur, __ATOMIC_RELAXED);
+  if (unlikely(!fn))
+    fn = infl_flush_select();
+  fn(dst, from, to);
+}
+#else
+UNZ_HIDE
+void
+infl_flush_lines(const uint8_t * __restrict dst, size_t from, size_t to) {
+  (void)dst;
+  (void)from;
+  (void)to;
+}
+#endif
+
+UNZ_HIDE UNZ_HOT
+UnzResult
+infl_ft_block(infl_ft_bits_t             * __restrict br,
+              uint8_t                    * __restrict dst,
+              size_t                     * __restrict dpos,
+              size_t                                  dst_cap,
+              const infl_ft_table_t      * __restrict tlit,
+              const infl_ft_dist_table_t * __restrict tdist) {
+  return infl_ft_impl()->block(br, dst, dpos, dst_cap, tlit, tdist);
+}
+
+UNZ_HIDE UNZ_HOT
+UnzResult
+infl_ft_fast(infl_ft_bits_t             * __restrict br,
+             uint8_t                    * __restrict dst,
+             size_t                     * __restrict dpos,
+             size_t                                  dst_cap,
+             const infl_ft_table_t      * __restrict tlit,
+             const infl_ft_dist_table_t * __restrict tdist) {
+  return infl_ft_impl()->fast(br, dst, dpos, dst_cap, tlit, tdist);
+}
+
+UNZ_HIDE
+UnzResult
+infl_ft_dynamic(infl_ft_bits_t       * __restrict br,
+                defl_stream_t        * __restrict stream,
+                const infl_ft_dyn_t ** __restrict dyn) {
+  union {
+    uint_fast8_t codelens[MAX_CODELEN_CODES];
+    uint8_t      lens[MAX_LITLEN_CODES + MAX_DIST_CODES];
+  } lens;
+  huff_fast_entry_t tcodelen[HUFF_FAST_TABLE_SIZE];
+  huff_fast_entry_t fe;
+  int               i, n, hclen, hlit, hdist, repeat;
+
+  memset(&lens, 0, sizeof(lens));
+
+  infl_ft_refill(br, 14);
+  if (unlikely(br->nbits < 14))
+    return UNZ_ERR;
+
+  hlit  = (int)(br->bits & 0x1Fu) + 257;
+  hdist = (int)((br->bits >> 5) & 0x1Fu) + 1;
+  hclen = (int)((br->bits >> 10) & 0xFu) + 4;
+  n     = hlit + hdist;
+  infl_ft_consume(br, 14);
+
+  if (unlikely(n > MAX_LITLEN_CODES + MAX_DIST_CODES))
+    return UNZ_ERR;
+
+  for (i = 0; i < hclen; i++) {
+    infl_ft_refill(br, 3);
+    if (unlikely(br->nbits < 3))
+      return UNZ_ERR;
+    lens.codelens[ord[i]] = (uint_fast8_t)(br->bits & 0x7u);
+    infl_ft_consume(br, 3);
+  }
+
+  if (unlikely(!huff_init_fast_lsb(tcodelen, (const uint8_t *)lens.codelens,
+                                  NULL, MAX_CODELEN_CODES)))
+    return UNZ_ERR;
+
+  for (i = MAX_CODELEN_CODES; i;)
+    lens.codelens[--i] = 0;
+
+  while (i < n) {
+    infl_ft_refill(br, 14);
+    if (unlikely(br->nbits < 7))
+      return UNZ_ERR;
+
+    fe = tcodelen[(uint8_t)br->bits];
+    if (unlikely(!fe.len || fe.sym > 18))
+      return UNZ_ERR;
+    infl_ft_consume(br, fe.len);
+
+    switch (fe.sym) {
+      default:
+        lens.lens[i++] = (uint8_t)fe.sym;
+        break;
+      case 16:
+        if (unlikely(br->nbits < 2 || i == 0))
+          return UNZ_ERR;
+        repeat = 3 + (int)(br->bits & 0x3u);
+        infl_ft_consume(br, 2);
+        if (unlikely(i + repeat > n))
+          return UNZ_ERR;
+        memset(lens.lens + i, lens.lens[i - 1], (size_t)repeat);
+        i += repeat;
+        break;
+      case 17:
+        if (unlikely(br->nbits < 3))
+          return UNZ_ERR;
+        repeat = 3 + (int)(br->bits & 0x7u);
+        infl_ft_consume(br, 3);
+        if (unlikely(i + repeat > n))
+          return UNZ_ERR;
+        i += repeat;
+        break;
+      case 18:
+        if (unlikely(br->nbits < 7))
+          return UNZ_ERR;
+        repeat = 11 + (int)(br->bits & 0x7Fu);
+        infl_ft_consume(br, 7);
+        if (unlikely(i + repeat > n))
+          return UNZ_ERR;
+        i += repeat;
+        break;
+    }
+  }
+
+  if (unlikely(!(*dyn = infl_ft_dyn_tables(stream, lens.lens,
+                                            (unsigned)hlit, (unsigned)hdist))))
+    return UNZ_ERR;
+
+  return UNZ_OK;
+}
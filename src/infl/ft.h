@@ -0,0 +1,570 @@
+/*
+ * Copyright (C) 2025 Recep Aslantas
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef infl_ft_h
+#define infl_ft_h
+
+#include "apicommon.h"
+
+UNZ_INLINE uint64_t
+infl_load64(const uint8_t * __restrict p) {
+  uint64_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+UNZ_INLINE void
+infl_store64(uint8_t * __restrict p, uint64_t v) {
+  memcpy(p, &v, sizeof(v));
+}
+
+UNZ_INLINE void
+infl_store16(uint8_t * __restrict p, uint16_t v) {
+  memcpy(p, &v, sizeof(v));
+}
+
+/* far match sources are usually out of l1 by the time they are copied */
+UNZ_INLINE void
+infl_ft_prefetch(const uint8_t *p) {
+#if defined(__GNUC__) || defined(__clang__)
+  __builtin_prefetch(p, 0, 3);
+#else
+  (void)p;
+#endif
+}
+
+/* INFL_NOCACHE stored copy, streaming stores do not pull dst into the cache.
+   a huffman block right after reads its window back from memory */
+UNZ_INLINE void
+infl_copy_nocache(uint8_t       * __restrict dst,
+                  const uint8_t * __restrict src,
+                  size_t                     len) {
+#if defined(__SSE2__)
+  if (len >= INFL_NOCACHE_COPY) {
+    size_t head;
+
+    head = (16u - ((uintptr_t)dst & 15u)) & 15u;
+    memcpy(dst, src, head);
+    dst += head;
+    src += head;
+    len -= head;
+
+    for (; len >= 64u; len -= 64u, dst += 64, src += 64) {
+      _mm_stream_si128((__m128i *)dst,        _mm_loadu_si128((const __m128i *)src));
+      _mm_stream_si128((__m128i *)(dst + 16), _mm_loadu_si128((const __m128i *)(src + 16)));
+      _mm_stream_si128((__m128i *)(dst + 32), _mm_loadu_si128((const __m128i *)(src + 32)));
+      _mm_stream_si128((__m128i *)(dst + 48), _mm_loadu_si128((const __m128i *)(src + 48)));
+    }
+    _mm_sfence();
+  }
+#endif
+  if (len)
+    memcpy(dst, src, len);
+}
+
+/* INFL_NOCACHE: write back and drop output lines [from, to) with clflushopt.
+   chosen by cpuid on first use, a no-op where the cpu lacks it. plain clflush
+   is ordered against every store and costs more than it gives back */
+UNZ_HIDE
+void
+infl_flush_lines(const uint8_t * __restrict dst, size_t from, size_t to);
+
+/* INFL_NOCACHE: drop the output from *from up to a window behind to, in
+   batches. only the window is read again */
+UNZ_INLINE void
+infl_evict(const uint8_t * __restrict dst, size_t * __restrict from, size_t to) {
+  size_t end;
+
+  if (to < *from + INFL_WINDOW + INFL_NOCACHE_BATCH)
+    return;
+
+  end = (to - INFL_WINDOW) & ~(size_t)(CACHE_LINE_SIZE - 1u);
+  infl_flush_lines(dst, *from & ~(size_t)(CACHE_LINE_SIZE - 1u), end);
+  *from = end;
+}
+
+#ifdef UNZ_STATS
+#  include <time.h>
+
+/* cycle counter for the table build stats, nanoseconds where there is none */
+UNZ_INLINE uint64_t
+infl_ft_cycles(void) {
+#  if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  return __builtin_ia32_rdtsc();
+#  elif defined(__GNUC__) && defined(__aarch64__)
+  uint64_t v;
+  __asm__ __volatile__("mrs %0, cntvct_el0" : "=r"(v));
+  return v;
+#  else
+  struct timespec ts;
+  timespec_get(&ts, TIME_UTC);
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#  endif
+}
+#endif
+
+UNZ_INLINE bitstream_t
+infl_load_partial_le(const uint8_t * __restrict p, size_t n) {
+  bitstream_t v;
+
+  if (likely(n == sizeof(uint64_t)))
+    return infl_load64(p);
+
+  v = 0;
+  switch (n) {
+    case 7: v |= (bitstream_t)p[6] << 48; /* fall through */
+    case 6: v |= (bitstream_t)p[5] << 40; /* fall through */
+    case 5: v |= (bitstream_t)p[4] << 32; /* fall through */
+    case 4: v |= (bitstream_t)p[3] << 24; /* fall through */
+    case 3: v |= (bitstream_t)p[2] << 16; /* fall through */
+    case 2: v |= (bitstream_t)p[1] << 8;  /* fall through */
+    case 1: v |= (bitstream_t)p[0];       /* fall through */
+    default: break;
+  }
+  return v;
+}
+
+UNZ_INLINE void
+infl_copy_rle(uint8_t * __restrict dst, size_t * __restrict dpos, unsigned len) {
+  uint8_t  byte;
+  uint64_t word;
+  size_t   pos, end;
+
+  pos  = *dpos;
+  byte = dst[pos - 1];
+  word = UINT64_C(0x0101010101010101) * byte;
+  end  = pos + len;
+
+  do {
+    infl_store64(dst + pos, word);
+    pos += 8;
+  } while (pos < end);
+
+  *dpos = end;
+}
+
+UNZ_INLINE void
+infl_copy_rle_overrun(uint8_t * __restrict dst, size_t * __restrict dpos, unsigned len) {
+  uint8_t  byte;
+  uint64_t word;
+  size_t   pos, end;
+
+  pos  = *dpos;
+  byte = dst[pos - 1];
+  word = UINT64_C(0x0101010101010101) * byte;
+  end  = pos + len;
+
+  do {
+    infl_store64(dst + pos,      word);
+    infl_store64(dst + pos + 8,  word);
+    infl_store64(dst + pos + 16, word);
+    infl_store64(dst + pos + 24, word);
+    infl_store64(dst + pos + 32, word);
+    pos += 40;
+  } while (pos < end);
+
+  *dpos = end;
+}
+
+UNZ_INLINE void
+infl_copy_match_word(uint8_t * __restrict dst,
+                     size_t  * __restrict dpos,
+                     unsigned             dist,
+                     unsigned             len) {
+  const uint8_t *src;
+  size_t         pos, end;
+
+  pos = *dpos;
+  src = dst + pos - dist;
+  end = pos + len;
+
+  do {
+    infl_store64(dst + pos, infl_load64(src));
+    src += 8;
+    pos += 8;
+  } while (pos < end);
+
+  *dpos = end;
+}
+
+UNZ_INLINE void
+infl_copy_match_small_overrun(uint8_t * __restrict dst,
+                              size_t  * __restrict dpos,
+                              unsigned             dist,
+                              unsigned             len) {
+  /* largest multiple of dist that fits in one word, for dist 2..7 */
+  static const uint8_t step[8] = {0, 8, 8, 6, 8, 5, 6, 7};
+  uint64_t word;
+  size_t   pos, end;
+  unsigned s;
+
+  pos = *dpos;
+  end = pos + len;
+
+  /* dist < 8: repeat the first dist bytes across a word once, then every
+     store starts on a period boundary and needs no reload from dst */
+  word = infl_load64(dst + pos - dist) & ((UINT64_C(1) << (dist << 3)) - 1u);
+  for (s = dist << 3; s < 64; s <<= 1)
+    word |= word << s;
+
+  do {
+    infl_store64(dst + pos, word);
+    pos += step[dist];
+  } while (pos < end);
+
+  *dpos = end;
+}
+
+UNZ_INLINE void
+infl_copy_match_overrun(uint8_t * __restrict dst,
+                        size_t  * __restrict dpos,
+                        unsigned             dist,
+                        unsigned             len) {
+  const uint8_t *src;
+  size_t         pos, end;
+
+  pos = *dpos;
+  src = dst + pos - dist;
+  end = pos + len;
+
+  do {
+    infl_store64(dst + pos,      infl_load64(src));
+    infl_store64(dst + pos + 8,  infl_load64(src + 8));
+    infl_store64(dst + pos + 16, infl_load64(src + 16));
+    infl_store64(dst + pos + 24, infl_load64(src + 24));
+    infl_store64(dst + pos + 32, infl_load64(src + 32));
+    src += 40;
+    pos += 40;
+  } while (pos < end);
+
+  *dpos = end;
+}
+
+#define INFL_FT_TOTAL(E)    ((unsigned)((E) & 31u))
+#define INFL_FT_CODELEN(E)  ((unsigned)(((E) >> 5) & 15u))
+#define INFL_FT_XBITS(E)    ((unsigned)(((E) >> 9) & 15u))
+#define INFL_FT_LITERAL     (1u << 13)
+#define INFL_FT_END         (1u << 14)
+#define INFL_FT_SUBTABLE    (1u << 15)
+#define INFL_FT_BASE(E)     ((unsigned)((E) >> 16))
+#define INFL_FT_ENTRY(BASE, XBITS, CODELEN, FLAGS) \
+  (((uint32_t)(BASE) << 16) | (uint32_t)(FLAGS) | ((uint32_t)(XBITS) << 9) | \
+   ((uint32_t)(CODELEN) << 5) | (uint32_t)((CODELEN) + (XBITS)))
+#define INFL_FT_SUBENTRY(BASE, SUBBITS, MAINBITS) \
+  (((uint32_t)(BASE) << 16) | INFL_FT_SUBTABLE | ((uint32_t)(SUBBITS) << 5) | \
+   (uint32_t)(MAINBITS))
+
+/* literal entries reuse the extra-bits field: bit 9 marks two literals packed
+   in BASE (first byte low), CODELEN is then the first literal's code length */
+#define INFL_FT_LITPAIR     (1u << 9)
+#define INFL_FT_LITCNT(E)   (1u + (((E) >> 9) & 1u))
+#define INFL_FT_PAIR(LIT1, LIT2, LEN1, LEN2) \
+  (((uint32_t)(LIT1) << 16) | ((uint32_t)(LIT2) << 24) | INFL_FT_LITERAL | \
+   INFL_FT_LITPAIR | ((uint32_t)(LEN1) << 5) | (uint32_t)((LEN1) + (LEN2)))
+
+/* stitch buffer: the last few bytes of a chunk joined with the head of the
+   following ones, so 8-byte loads never straddle a chunk edge */
+#define INFL_FT_STITCH      32u
+
+typedef struct infl_ft_bits_t {
+  unz_chunk_t   *chunk; /* current chunk, NULL for a single contiguous input */
+  const uint8_t *p;
+  const uint8_t *end;
+  bitstream_t    bits;
+  unsigned       nbits;
+  const uint8_t *sp;    /* non-NULL while p/end point into stitch: stitch[0]
+                           is the byte at sp in chunk */
+  uint8_t        stitch[INFL_FT_STITCH];
+  const uint8_t *lim;   /* non-NULL in padded tail mode: the real end of input
+                           in stitch, end is past it over zero padding */
+  bool           pad;   /* input is complete, the last chunk may be padded */
+} infl_ft_bits_t;
+
+/* widest copy step of any decode loop variant: five words for the scalar
+   kernels, one 64-byte vector with avx-512 */
+#define INFL_FT_SLACK_WORD  40u
+#if INFL_FT_DISPATCH
+#  define INFL_FT_SLACK_MAX 64u
+#else
+#  define INFL_FT_SLACK_MAX INFL_FT_SLACK_WORD
+#endif
+
+/* infl_ft_fast() margins: one unchecked 8-byte load per iteration on the input
+   side, the longest match plus the copy overrun on the output side */
+#define INFL_FT_FAST_IN     8u
+#define INFL_FT_FAST_OUT    (258u + INFL_FT_SLACK_MAX)
+
+/* slow path of the refills: point p/end back into the chunk chain, then
+   either read the current chunk in place or stitch its tail to the following
+   chunks. returns false once no input is left */
+UNZ_HIDE
+bool
+infl_ft_next_chunk(infl_ft_bits_t * __restrict br);
+
+/* move p/end out of the stitch buffer before the reader state is saved,
+   after infl_ft_settle() in padded tail mode */
+UNZ_HIDE
+void
+infl_ft_unstitch(infl_ft_bits_t * __restrict br);
+
+/* padded tail mode: give back the zero bytes loaded past the end of input.
+   false if any of them was consumed, the input is truncated */
+UNZ_INLINE bool
+infl_ft_settle(infl_ft_bits_t * __restrict br) {
+  size_t over;
+
+  if (likely(!br->lim || br->p <= br->lim))
+    return true;
+
+  over = (size_t)(br->p - br->lim);
+  if (unlikely(over > (br->nbits >> 3)))
+    return false;
+
+  /* the bits given back are zeros, nothing to clear above nbits */
+  br->p     -= over;
+  br->nbits -= (unsigned)(over << 3);
+  return true;
+}
+
+UNZ_INLINE void
+infl_ft_refill(infl_ft_bits_t * __restrict br, unsigned need) {
+  while (br->nbits < need) {
+    size_t n, avail;
+
+    if (unlikely((size_t)(br->end - br->p) < sizeof(uint64_t)) && br->chunk
+        && !infl_ft_next_chunk(br))
+      break;
+
+    n     = (64u - br->nbits) >> 3;
+    avail = (size_t)(br->end - br->p);
+    if (n > avail)
+      n = avail;
+    if (!n)
+      break;
+
+    br->bits  |= infl_load_partial_le(br->p, n) << br->nbits;
+    br->p     += n;
+    br->nbits += (unsigned)(n << 3);
+  }
+}
+
+UNZ_INLINE void
+infl_ft_refill_fast(infl_ft_bits_t * __restrict br, unsigned need) {
+  const unsigned bit_width = (unsigned)(sizeof(bitstream_t) * 8u);
+
+  if (likely(br->nbits >= need))
+    return;
+
+  if (likely((size_t)(br->end - br->p) >= sizeof(uint64_t))) {
+    bitstream_t loaded;
+    unsigned    loaded_bits;
+    unsigned    n;
+
+    n = (bit_width - br->nbits) >> 3;
+    if (n > sizeof(uint64_t))
+      n = sizeof(uint64_t);
+    if (likely(n > 0)) {
+      loaded = (bitstream_t)infl_load64(br->p);
+      loaded_bits = n << 3;
+      if (loaded_bits < bit_width)
+        loaded &= (((bitstream_t)1 << loaded_bits) - 1u);
+
+      br->bits  |= loaded << br->nbits;
+      br->p     += n;
+      br->nbits += loaded_bits;
+      return;
+    }
+  }
+
+  infl_ft_refill(br, need);
+}
+
+/* caller guarantees INFL_FT_FAST_IN readable bytes at br->p and nbits < 64 */
+UNZ_INLINE void
+infl_ft_refill_unchecked(infl_ft_bits_t * __restrict br) {
+  unsigned n;
+
+  n          = (63u - br->nbits) >> 3;
+  br->bits  |= (infl_load64(br->p) & (((bitstream_t)1 << (n << 3)) - 1u)) << br->nbits;
+  br->p     += n;
+  br->nbits += n << 3;
+}
+
+/* emits the one or two literals of a literal entry, always stores two bytes */
+UNZ_INLINE void
+infl_ft_put_lit(uint8_t  * __restrict dst,
+                size_t   * __restrict pos,
+                uint32_t              entry) {
+#if INFL_FT_LITPAIRS
+  infl_store16(dst + *pos, (uint16_t)INFL_FT_BASE(entry));
+  *pos += INFL_FT_LITCNT(entry);
+#else
+  dst[(*pos)++] = (uint8_t)INFL_FT_BASE(entry);
+#endif
+}
+
+UNZ_INLINE void
+infl_ft_consume(infl_ft_bits_t * __restrict br, unsigned n) {
+  br->bits >>= n;
+  br->nbits -= n;
+}
+
+UNZ_INLINE uint32_t
+infl_ft_lookup_lit(const infl_ft_table_t * __restrict tab, bitstream_t bits) {
+  uint32_t entry;
+
+  entry = tab->table[bits & ((1u << INFL_FT_LIT_BITS) - 1u)];
+  if (likely(!(entry & INFL_FT_SUBTABLE)))
+    return entry;
+
+  return tab->table[INFL_FT_BASE(entry) +
+                    ((bits >> INFL_FT_LIT_BITS) & ((1u << INFL_FT_CODELEN(entry)) - 1u))];
+}
+
+UNZ_INLINE uint32_t
+infl_ft_lookup_dist(const infl_ft_dist_table_t * __restrict tab, bitstream_t bits) {
+  uint32_t entry;
+
+  entry = tab->table[bits & ((1u << INFL_FT_DIST_BITS) - 1u)];
+  if (likely(!(entry & INFL_FT_SUBTABLE)))
+    return entry;
+
+  return tab->table[INFL_FT_BASE(entry) +
+                    ((bits >> INFL_FT_DIST_BITS) & ((1u << INFL_FT_CODELEN(entry)) - 1u))];
+}
+
+UNZ_HIDE
+bool
+infl_ft_build(uint32_t      * __restrict table,
+              uint16_t      * __restrict used_out,
+              const uint8_t * __restrict lens,
+              uint16_t                   nsyms,
+              unsigned                   tablebits,
+              unsigned                   cap,
+              bool                       litlen);
+
+UNZ_HIDE
+bool
+infl_ft_tables(infl_ft_table_t      * __restrict tlit,
+               infl_ft_dist_table_t * __restrict tdist,
+               const uint8_t        * __restrict lens,
+               unsigned                          hlit,
+               unsigned                          hdist);
+
+/* prebuilt fixed huffman tables (fixed.h), read-only and shared by all paths */
+UNZ_HIDE extern const infl_ft_table_t      infl_ft_fixed_lit;
+UNZ_HIDE extern const infl_ft_dist_table_t infl_ft_fixed_dist;
+
+#ifdef INFL_MAKEFIXED
+UNZ_HIDE
+int
+infl_ft_makefixed(FILE * __restrict out);
+#endif
+
+UNZ_HIDE
+UnzResult
+infl_ft_stored(infl_ft_bits_t * __restrict br,
+               uint8_t        * __restrict dst,
+               size_t         * __restrict dpos,
+               size_t                      dst_cap,
+               bool                        nocache);
+
+/* infl_ft_block() and infl_ft_fast() dispatch to a generic, bmi2, avx2 or
+   avx-512 build of the loop chosen by cpuid on first use (see ft_loop.h) */
+UNZ_HIDE
+UnzResult
+infl_ft_block(infl_ft_bits_t             * __restrict br,
+              uint8_t                    * __restrict dst,
+              size_t                     * __restrict dpos,
+              size_t                                  dst_cap,
+              const infl_ft_table_t      * __restrict tlit,
+              const infl_ft_dist_table_t * __restrict tdist);
+
+/*
+ * unchecked decode loop, runs while INFL_FT_FAST_IN input bytes are left in
+ * the current chunk and INFL_FT_FAST_OUT bytes of output room. returns UNZ_OK
+ * at end of block, UNZ_UNFINISHED at a symbol boundary once a margin is hit
+ */
+UNZ_HIDE
+UnzResult
+infl_ft_fast(infl_ft_bits_t             * __restrict br,
+             uint8_t                    * __restrict dst,
+             size_t                     * __restrict dpos,
+             size_t                                  dst_cap,
+             const infl_ft_table_t      * __restrict tlit,
+             const infl_ft_dist_table_t * __restrict tdist);
+
+/* the stream's table cache, allocated on first use. NULL if out of memory */
+UNZ_HIDE
+infl_ft_cache_t *
+infl_ft_cache(defl_stream_t * __restrict stream);
+
+/*
+ * tables for the code lengths of one dynamic header: a cached entry when a
+ * recent block used the same lengths, else built into the oldest cache slot.
+ * the entry stays valid until the next call. NULL on bad lengths or no memory
+ */
+UNZ_HIDE
+const infl_ft_dyn_t *
+infl_ft_dyn_tables(defl_stream_t * __restrict stream,
+                   const uint8_t * __restrict lens,
+                   unsigned                   hlit,
+                   unsigned                   hdist);
+
+UNZ_HIDE
+UnzResult
+infl_ft_dynamic(infl_ft_bits_t       * __restrict br,
+                defl_stream_t        * __restrict stream,
+                const infl_ft_dyn_t ** __restrict dyn);
+
+/* infl_stream() body, also run by infl() on a sink stream (all: go on with the
+   included chunks when no new data is given). on UNZ_EFULL a sink stream hands
+   over its slices and slides the window, a growable one grows its output and
+   an iov one moves on to the next segment */
+UNZ_HIDE
+int
+infl_strm_drive(infl_stream_t * __restrict stream,
+                const void    * __restrict src,
+                size_t                     srclen,
+                bool                       all);
+
+/* infl_init_grow(): double the output with infl_mem_realloc(). false if out
+   of memory or size, the output is left as it was */
+UNZ_HIDE
+bool
+infl_grow(defl_stream_t * __restrict stream);
+
+/* malloc(), posix_memalign() and free(), the allocator of infl_init() */
+UNZ_HIDE extern const infl_alloc_t infl_libc;
+
+/* allocate from the stream's allocator and keep meminuse / mempeak, sizes
+   must match the ones allocated with */
+UNZ_HIDE
+void *
+infl_mem_alloc(infl_stream_t * __restrict stream, size_t size, size_t align);
+
+UNZ_HIDE
+void *
+infl_mem_realloc(infl_stream_t * __restrict stream,
+                 void          *            p,
+                 size_t                     oldsize,
+                 size_t                     size);
+
+UNZ_HIDE
+void
+infl_mem_free(infl_stream_t * __restrict stream, void *p, size_t size);
+
+#endif /* infl_ft_h */
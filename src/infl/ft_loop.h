@@ -0,0 +1,326 @@
+/*
+ * Copyright (C) 2025 Recep Aslantas
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * decode loop body, included by ft.c once per instruction set variant.
+ * the includer defines:
+ *   INFL_FT_FN(NAME)    variant name of NAME
+ *   INFL_FT_TARGET      function attributes enabling the variant's ISA
+ *   INFL_FT_COPY_MATCH  overrun match copy for dist >= 8
+ *   INFL_FT_COPY_RLE    overrun byte fill for dist == 1
+ *   INFL_FT_COPY_SMALL  overrun pattern copy for dist 2..7
+ *   INFL_FT_SLACK       widest copy step, the copies write at most
+ *                       INFL_FT_SLACK - 1 bytes past the match end
+ * no include guard on purpose
+ */
+
+static UNZ_HOT INFL_FT_TARGET
+UnzResult
+INFL_FT_FN(infl_ft_block)(infl_ft_bits_t             * __restrict br,
+                          uint8_t                    * __restrict dst,
+                          size_t                     * __restrict dpos,
+                          size_t                                  dst_cap,
+                          const infl_ft_table_t      * __restrict tlit,
+                          const infl_ft_dist_table_t * __restrict tdist) {
+  size_t   pos, out_rem, src;
+  unsigned len, dist, total, code_len, base;
+  uint32_t entry;
+  bool     fast_copy;
+
+  pos = *dpos;
+  infl_ft_refill_fast(br, 32);
+  entry = infl_ft_lookup_lit(tlit, br->bits);
+
+  for (;;) {
+    bitstream_t saved;
+
+    if (unlikely(!entry))
+      return UNZ_ERR;
+
+    total = INFL_FT_TOTAL(entry);
+
+    if (unlikely(br->nbits < total)) {
+      infl_ft_refill(br, total);
+      if (unlikely(br->nbits < total))
+        return UNZ_ERR;
+    }
+
+    if (likely(entry & INFL_FT_LITERAL)) {
+      infl_ft_consume(br, total);
+
+      if (likely(dst_cap - pos >= 2))
+        infl_ft_put_lit(dst, &pos, entry);
+      else if (pos < dst_cap && INFL_FT_LITCNT(entry) == 1)
+        dst[pos++] = (uint8_t)INFL_FT_BASE(entry);
+      else
+        return UNZ_EFULL;
+
+      for (unsigned litrun = 2; litrun; litrun--) {
+        if (unlikely(br->nbits < 15)) {
+          infl_ft_refill_fast(br, 32);
+          if (unlikely(br->nbits < 15))
+            break;
+        }
+
+        entry = infl_ft_lookup_lit(tlit, br->bits);
+        if (unlikely((entry & INFL_FT_LITERAL) == 0))
+          goto next_symbol_ready;
+
+        total = INFL_FT_TOTAL(entry);
+        if (unlikely(br->nbits < total || dst_cap - pos < 2))
+          break;
+
+        infl_ft_put_lit(dst, &pos, entry);
+        infl_ft_consume(br, total);
+      }
+
+      infl_ft_refill_fast(br, 32);
+      entry = infl_ft_lookup_lit(tlit, br->bits);
+next_symbol_ready:
+      continue;
+    }
+
+    if (unlikely(entry & INFL_FT_END)) {
+      infl_ft_consume(br, total);
+      break;
+    }
+
+    saved    = br->bits;
+    code_len = INFL_FT_CODELEN(entry);
+    base     = INFL_FT_BASE(entry);
+    infl_ft_consume(br, total);
+    len = base + (unsigned)((saved & (((bitstream_t)1 << total) - 1u)) >> code_len);
+
+    if (unlikely(br->nbits < 15)) {
+      infl_ft_refill_fast(br, 32);
+    }
+
+    entry = infl_ft_lookup_dist(tdist, br->bits);
+    if (unlikely(!entry))
+      return UNZ_ERR;
+
+    saved    = br->bits;
+    total    = INFL_FT_TOTAL(entry);
+    code_len = INFL_FT_CODELEN(entry);
+    dist     = INFL_FT_BASE(entry);
+
+    if (unlikely(br->nbits < total)) {
+      infl_ft_refill(br, total);
+      if (unlikely(br->nbits < total))
+        return UNZ_ERR;
+      saved = br->bits;
+    }
+
+    infl_ft_consume(br, total);
+    dist += (unsigned)((saved & (((bitstream_t)1 << total) - 1u)) >> code_len);
+
+    if (unlikely(!dist || (size_t)dist > pos))
+      return UNZ_ERR;
+
+#if INFL_FT_PREFETCH
+    if (dist >= INFL_FT_PREFETCH)
+      infl_ft_prefetch(dst + pos - dist);
+#endif
+
+    out_rem = dst_cap - pos;
+    if (unlikely(len > out_rem))
+      return UNZ_EFULL;
+    fast_copy = likely(out_rem >= 258u + INFL_FT_SLACK - 1u);
+
+    infl_ft_refill_fast(br, 32);
+    entry = infl_ft_lookup_lit(tlit, br->bits);
+
+    if (dist >= 8
+        && likely(fast_copy || (len >= 16 && len + INFL_FT_SLACK - 1u <= out_rem))) {
+      INFL_FT_COPY_MATCH(dst, &pos, dist, len);
+    } else if (dist >= 8 && likely(len + 7 <= out_rem)) {
+      infl_copy_match_word(dst, &pos, dist, len);
+    } else if (dist == 1
+               && likely(fast_copy || (len >= 32 && len + INFL_FT_SLACK - 1u <= out_rem))) {
+      INFL_FT_COPY_RLE(dst, &pos, len);
+    } else if (dist == 1 && likely(len + 7 <= out_rem)) {
+      infl_copy_rle(dst, &pos, len);
+    } else if (dist == 1) {
+      unsigned byte = dst[pos - 1];
+
+      while (len >= 8) {
+        dst[pos]   = (uint8_t)byte;
+        dst[pos+1] = (uint8_t)byte;
+        dst[pos+2] = (uint8_t)byte;
+        dst[pos+3] = (uint8_t)byte;
+        dst[pos+4] = (uint8_t)byte;
+        dst[pos+5] = (uint8_t)byte;
+        dst[pos+6] = (uint8_t)byte;
+        dst[pos+7] = (uint8_t)byte;
+        len -= 8; pos += 8;
+      }
+      while (len >= 4) {
+        dst[pos]   = (uint8_t)byte;
+        dst[pos+1] = (uint8_t)byte;
+        dst[pos+2] = (uint8_t)byte;
+        dst[pos+3] = (uint8_t)byte;
+        len -= 4; pos += 4;
+      }
+      if (len >= 1) {
+        dst[pos] = (uint8_t)byte;
+        switch (len - 1) {
+          case 2: dst[pos+2] = (uint8_t)byte; /* fall through */
+          case 1: dst[pos+1] = (uint8_t)byte; break;
+          case 0:                         break;
+        }
+        pos += len;
+      }
+    } else if (likely(fast_copy || len + INFL_FT_SLACK - 1u <= out_rem)) {
+      INFL_FT_COPY_SMALL(dst, &pos, dist, len);
+    } else if (likely(len + 7 <= out_rem)) {
+      infl_copy_match_small_overrun(dst, &pos, dist, len);
+    } else {
+      src = pos - dist;
+      while (len >= 8) {
+        dst[pos]   = dst[src];
+        dst[pos+1] = dst[src+1];
+        dst[pos+2] = dst[src+2];
+        dst[pos+3] = dst[src+3];
+        dst[pos+4] = dst[src+4];
+        dst[pos+5] = dst[src+5];
+        dst[pos+6] = dst[src+6];
+        dst[pos+7] = dst[src+7];
+        len -= 8; pos += 8; src += 8;
+      }
+      while (len >= 4) {
+        dst[pos]   = dst[src];
+        dst[pos+1] = dst[src+1];
+        dst[pos+2] = dst[src+2];
+        dst[pos+3] = dst[src+3];
+        len -= 4; pos += 4; src += 4;
+      }
+      if (len >= 1) {
+        dst[pos] = dst[src];
+        switch (len - 1) {
+          case 2: dst[pos+2] = dst[src+2]; /* fall through */
+          case 1: dst[pos+1] = dst[src+1]; break;
+          case 0:                         break;
+        }
+        pos += len;
+      }
+    }
+  }
+
+  *dpos = pos;
+  return UNZ_OK;
+}
+
+static UNZ_HOT INFL_FT_TARGET
+UnzResult
+INFL_FT_FN(infl_ft_fast)(infl_ft_bits_t             * __restrict br,
+                         uint8_t                    * __restrict dst,
+                         size_t                     * __restrict dpos,
+                         size_t                                  dst_cap,
+                         const infl_ft_table_t      * __restrict tlit,
+                         const infl_ft_dist_table_t * __restrict tdist) {
+  const uint8_t *in_last;
+  size_t         pos, out_last;
+  unsigned       len, dist, total;
+  uint32_t       entry;
+  UnzResult      res;
+
+  pos = *dpos;
+  if ((size_t)(br->end - br->p) < INFL_FT_FAST_IN ||
+      pos > dst_cap || dst_cap - pos < 258u + INFL_FT_SLACK)
+    return UNZ_UNFINISHED;
+
+  in_last  = br->end - INFL_FT_FAST_IN;
+  out_last = dst_cap - (258u + INFL_FT_SLACK);
+  res      = UNZ_UNFINISHED;
+
+  /* one refill leaves >= 56 bits: enough for three literal entries or a full
+     length/distance pair (15 + 5 + 15 + 13), so no checks inside a symbol.
+     three literal entries write at most six bytes, well inside the margin */
+  while (br->p <= in_last && pos <= out_last) {
+    bitstream_t saved;
+
+    if (likely(br->nbits < 56))
+      infl_ft_refill_unchecked(br);
+
+    entry = infl_ft_lookup_lit(tlit, br->bits);
+    if (likely(entry & INFL_FT_LITERAL)) {
+      infl_ft_consume(br, INFL_FT_TOTAL(entry));
+      infl_ft_put_lit(dst, &pos, entry);
+
+      entry = infl_ft_lookup_lit(tlit, br->bits);
+      if (!(entry & INFL_FT_LITERAL))
+        continue;
+      infl_ft_consume(br, INFL_FT_TOTAL(entry));
+      infl_ft_put_lit(dst, &pos, entry);
+
+      entry = infl_ft_lookup_lit(tlit, br->bits);
+      if (!(entry & INFL_FT_LITERAL))
+        continue;
+      infl_ft_consume(br, INFL_FT_TOTAL(entry));
+      infl_ft_put_lit(dst, &pos, entry);
+      continue;
+    }
+
+    if (unlikely(entry & INFL_FT_END)) {
+      infl_ft_consume(br, INFL_FT_TOTAL(entry));
+      res = UNZ_OK;
+      break;
+    }
+
+    if (unlikely(!entry)) {
+      res = UNZ_ERR;
+      break;
+    }
+
+    saved = br->bits;
+    total = INFL_FT_TOTAL(entry);
+    infl_ft_consume(br, total);
+    len   = INFL_FT_BASE(entry)
+          + (unsigned)(EXTRACT(saved, total) >> INFL_FT_CODELEN(entry));
+
+    entry = infl_ft_lookup_dist(tdist, br->bits);
+    if (unlikely(!entry)) {
+      res = UNZ_ERR;
+      break;
+    }
+
+    saved = br->bits;
+    total = INFL_FT_TOTAL(entry);
+    infl_ft_consume(br, total);
+    dist  = INFL_FT_BASE(entry)
+          + (unsigned)(EXTRACT(saved, total) >> INFL_FT_CODELEN(entry));
+
+    if (unlikely((size_t)dist > pos)) {
+      res = UNZ_ERR;
+      break;
+    }
+
+#if INFL_FT_PREFETCH
+    if (dist >= INFL_FT_PREFETCH)
+      infl_ft_prefetch(dst + pos - dist);
+#endif
+
+    if (dist >= 8)
+      INFL_FT_COPY_MATCH(dst, &pos, dist, len);
+    else if (dist == 1)
+      INFL_FT_COPY_RLE(dst, &pos, len);
+    else
+      INFL_FT_COPY_SMALL(dst, &pos, dist, len);
+  }
+
+  *dpos = pos;
+  return res;
+}
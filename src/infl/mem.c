@@ -17,58 +17,151 @@
 #include "../common.h"
 #include "../../include/defl/infl.h"
 
- /* Platform-specific aligned allocation helpers */
+#include "ft.h"
+
 #ifdef _WIN32
 #  include <malloc.h>
-#  define ALIGNED_ALLOC(ptr, alignment, size) \
-      ((*(ptr) = _aligned_malloc((size), (alignment))) != NULL ? 0 : -1)
-#  define ALIGNED_FREE(ptr) _aligned_free(ptr)
+#  include <windows.h>
 #else
-#  include <unistd.h>
-  /* POSIX systems (Linux, macOS, etc.) */
-#  define ALIGNED_ALLOC(ptr, alignment, size) \
-      posix_memalign((void**)(ptr), (alignment), (size))
-#  define ALIGNED_FREE(ptr) free(ptr)
+#  include <pthread.h>
 #endif
 
-/* get a chunk from pool or create new one */
-static unz_chunk_t *
-get_pooled_chunk(infl_stream_t * __restrict stream) {
-  unz_chunk_t *chk;
-  int          idx;
+/* libc allocator for infl_init(). unaligned blocks come from malloc() on every
+   platform, infl_take_output() hands them out to be released with free().
+   aligned blocks come from posix_memalign(), which free() also releases, or
+   from _aligned_malloc() on windows, see infl_mem_free_aligned() */
+static void *
+infl_libc_alloc(void *ctx, size_t size, size_t align) {
+#ifndef _WIN32
+  void *p;
+#endif
 
-  if (stream->pool_used >= UNZ_CHUNK_POOL_SIZE)
+  (void)ctx;
+  if (!align)
+    return malloc(size);
+#ifdef _WIN32
+  return _aligned_malloc(size, align);
+#else
+  return posix_memalign(&p, align, size) == 0 ? p : NULL;
+#endif
+}
+
+/* only called for unaligned blocks */
+static void *
+infl_libc_realloc(void *ctx, void *p, size_t oldsize, size_t size) {
+  (void)ctx; (void)oldsize;
+  return realloc(p, size);
+}
+
+static void
+infl_libc_free(void *ctx, void *p, size_t size) {
+  (void)ctx; (void)size;
+  free(p);
+}
+
+UNZ_HIDE const infl_alloc_t infl_libc = {
+  infl_libc_alloc, infl_libc_realloc, infl_libc_free, NULL
+};
+
+UNZ_HIDE
+void *
+infl_mem_alloc(infl_stream_t * __restrict stream, size_t size, size_t align) {
+  void *p;
+
+  if (!(p = stream->mem.alloc(stream->mem.ctx, size, align)))
     return NULL;
 
-  idx = stream->pool_used;
-  chk = stream->chunk_pool[idx];
+  stream->meminuse += size;
+  if (stream->meminuse > stream->mempeak)
+    stream->mempeak = stream->meminuse;
+  return p;
+}
+
+UNZ_HIDE
+void *
+infl_mem_realloc(infl_stream_t * __restrict stream,
+                 void          *            p,
+                 size_t                     oldsize,
+                 size_t                     size) {
+  void *q;
 
-  if (!chk) {
-    chk = calloc(1, sizeof(*chk));
-    if (!chk)
+  if (!p)
+    return infl_mem_alloc(stream, size, 0);
+
+  if (stream->mem.realloc) {
+    if (!(q = stream->mem.realloc(stream->mem.ctx, p, oldsize, size)))
       return NULL;
+  } else {
+    if (!(q = stream->mem.alloc(stream->mem.ctx, size, 0)))
+      return NULL;
+    memcpy(q, p, oldsize < size ? oldsize : size);
+    stream->mem.free(stream->mem.ctx, p, oldsize);
+  }
+
+  stream->meminuse = stream->meminuse - oldsize + size;
+  if (stream->meminuse > stream->mempeak)
+    stream->mempeak = stream->meminuse;
+  return q;
+}
 
-    if (ALIGNED_ALLOC(&stream->chunk_buffers[idx], 64, UNZ_CHUNK_PAGE_SIZE) != 0) {
+UNZ_HIDE
+void
+infl_mem_free(infl_stream_t * __restrict stream, void *p, size_t size) {
+  if (!p)
+    return;
+
+  stream->mem.free(stream->mem.ctx, p, size);
+  stream->meminuse -= size;
+}
+
+/* free a block allocated with a nonzero align. the free callback is not told
+   the alignment, the libc one on windows needs it for _aligned_free() */
+static void
+infl_mem_free_aligned(infl_stream_t * __restrict stream, void *p, size_t size) {
 #ifdef _WIN32
-      free(chk);
-      return NULL;
-#else
-      stream->chunk_buffers[idx] = malloc(UNZ_CHUNK_PAGE_SIZE);
-      if (!stream->chunk_buffers[idx]) {
-        free(chk);
-        return NULL;
-      }
+  if (p && stream->mem.free == infl_libc_free) {
+    _aligned_free(p);
+    stream->meminuse -= size;
+    return;
+  }
 #endif
-    }
+  infl_mem_free(stream, p, size);
+}
+
+UNZ_EXPORT
+void
+infl_mem_usage(const infl_stream_t * __restrict stream,
+               size_t              * __restrict inuse,
+               size_t              * __restrict peak) {
+  if (inuse) *inuse = stream ? stream->meminuse : 0u;
+  if (peak)  *peak  = stream ? stream->mempeak  : 0u;
+}
 
-    chk->buffer        = stream->chunk_buffers[idx];
-    chk->buffer_size   = UNZ_CHUNK_PAGE_SIZE;
-    chk->is_pooled     = true;
-    chk->is_appendable = true;
-    stream->chunk_pool[idx] = chk;
+/* get a chunk from pool or create new one */
+static unz_chunk_t *
+get_pooled_chunk(infl_stream_t * __restrict stream) {
+  unz_chunk_page_t *pg;
+  unz_chunk_t      *chk;
+
+  if (stream->pool_used >= UNZ_CHUNK_POOL_SIZE)
+    return NULL;
+
+  pg = stream->page ? stream->page->next : stream->pages;
+  if (!pg) {
+    if (!(pg = infl_mem_alloc(stream, sizeof(*pg), 64)))
+      return NULL;
+
+    pg->next = NULL;
+    if (stream->page) stream->page->next = pg;
+    else              stream->pages      = pg;
   }
 
-  stream->pool_used = idx + 1;
+  stream->page = pg;
+  stream->pool_used++;
+
+  chk                = &pg->chk;
+  chk->buffer        = pg->buffer;
+  chk->buffer_size   = UNZ_CHUNK_PAGE_SIZE;
   chk->used          = 0;
   chk->p             = chk->buffer;
   chk->end           = chk->buffer;
@@ -77,33 +170,54 @@ get_pooled_chunk(infl_stream_t * __restrict stream) {
   return chk;
 }
 
-/* get a chunk structure from the struct pool */
+/* get a chunk structure from the slabs */
 static unz_chunk_t *
 get_pooled_chunk_struct(infl_stream_t * __restrict stream) {
-  unz_chunk_t *chk;
-  int          idx;
+  unz_chunk_slab_t *slab;
+  unz_chunk_t      *chk;
 
-  if (stream->struct_pool_used >= UNZ_CHUNK_STRUCT_POOL_SIZE)
-    return NULL;
+  if (!(slab = stream->slab) || stream->slab_used == UNZ_CHUNK_SLAB_SIZE) {
+    slab = slab ? slab->next : stream->slabs;
+    if (!slab) {
+      if (!(slab = infl_mem_alloc(stream, sizeof(*slab), 0)))
+        return NULL;
 
-  idx = stream->struct_pool_used;
-  chk = stream->chunk_struct_pool[idx];
-  if (!chk) {
-    chk = calloc(1, sizeof(*chk));
-    if (!chk)
-      return NULL;
-    stream->chunk_struct_pool[idx] = chk;
+      slab->next = NULL;
+      if (stream->slab) stream->slab->next = slab;
+      else              stream->slabs      = slab;
+    }
+    stream->slab      = slab;
+    stream->slab_used = 0;
   }
 
-  stream->struct_pool_used = idx + 1;
-
+  chk                = &slab->chk[stream->slab_used++];
   chk->next          = NULL;
-  chk->is_pooled     = true;
   chk->is_appendable = false;
 
   return chk;
 }
 
+/* dynamic table cache, allocated with the tables' 64-byte alignment */
+UNZ_HIDE
+infl_ft_cache_t *
+infl_ft_cache(infl_stream_t * __restrict stream) {
+  infl_ft_cache_t *cache;
+  int              i;
+
+  if ((cache = stream->ftcache))
+    return cache;
+
+  if (!(cache = infl_mem_alloc(stream, sizeof(*cache), CACHE_LINE_SIZE)))
+    return NULL;
+
+  /* only the keys need clearing, an empty slot never matches */
+  for (i = 0; i < INFL_FT_CACHE_SIZE; i++)
+    cache->ent[i].n = 0;
+  cache->next     = 0;
+  stream->ftcache = cache;
+  return cache;
+}
+
 /* Let the platform memcpy handle size/alignment-specific dispatch. */
 static inline void
 fast_memcpy(uint8_t * __restrict dst, const uint8_t * __restrict src, size_t len) {
@@ -115,7 +229,7 @@ UNZ_EXPORT
 void
 infl_include(infl_stream_t * __restrict stream,
              const void    * __restrict ptr,
-             uint32_t                   len) {
+             size_t                     len) {
   unz_chunk_t *chk;
   
   if (stream->current_appendable &&
@@ -150,13 +264,13 @@ infl_include(infl_stream_t * __restrict stream,
       chk->is_appendable         = true;
       stream->current_appendable = chk;
     } else {
-      /* pool exhausted, fall back to direct allocation */
-      goto fallback_alloc;
+      /* page pool exhausted, point at the data instead */
+      goto direct_chunk;
     }
   } else {
     if (len <= UNZ_CHUNK_PAGE_SIZE && stream->start && stream->start == stream->end &&
         !stream->current_appendable && stream->srclen <= UNZ_CHUNK_PAGE_SIZE - len &&
-        stream->start->is_pooled && stream->start->p && stream->start->end) {
+        stream->start->p && stream->start->end) {
       unz_chunk_t *first;
       size_t       first_len;
 
@@ -181,16 +295,9 @@ infl_include(infl_stream_t * __restrict stream,
       }
     }
 
-    /* large chunk: try to use pooled chunk structure first */
+    /* large chunk: point at the data */
 direct_chunk:
-    chk = get_pooled_chunk_struct(stream);
-    if (!chk) {
-      /* structure pool exhausted, fall back to calloc */
-fallback_alloc:
-      chk = calloc(1, sizeof(*chk));
-      if (!chk) return;
-      chk->is_pooled = false;
-    }
+    if (!(chk = get_pooled_chunk_struct(stream))) return;
     
     /* set up direct pointer (no copying for large chunks) */
     chk->p             = ptr;
@@ -219,10 +326,12 @@ fallback_alloc:
 UNZ_EXPORT
 void
 infl_reset_pool(infl_stream_t * __restrict stream) {
+  stream->page      = NULL;
   stream->pool_used = 0;
   
   /* reset structure pool */
-  stream->struct_pool_used = 0;
+  stream->slab      = NULL;
+  stream->slab_used = 0;
   
   /* Reset stream state */
   stream->current_appendable = NULL;
@@ -231,6 +340,29 @@ infl_reset_pool(infl_stream_t * __restrict stream) {
   stream->srclen             = 0;
 }
 
+/* free the output a sink, growable or iov stream owns, back to a plain one */
+static void
+infl_drop_output(infl_stream_t * __restrict stream) {
+  if (stream->sink || stream->grow)
+    infl_mem_free(stream, stream->dst, stream->dstlen);
+  if (stream->shadow) {
+    infl_mem_free(stream, stream->shadow, INFL_WINDOW * 2u);
+    infl_mem_free(stream, stream->iov, stream->iovcap * sizeof(*stream->iov));
+  }
+
+  stream->dst       = NULL;
+  stream->dstlen    = 0;
+  stream->sink      = NULL;
+  stream->sinkctx   = NULL;
+  stream->slice     = 0;
+  stream->grow      = false;
+  stream->shadow    = NULL;
+  stream->iov       = NULL;
+  stream->niov      = 0;
+  stream->iovcap    = 0;
+  stream->iovdirect = false;
+}
+
 static inline void
 infl_reset_state(infl_stream_t * __restrict stream) {
   memset(&stream->bs, 0, sizeof(stream->bs));
@@ -249,27 +381,53 @@ infl_reset_state(infl_stream_t * __restrict stream) {
   stream->ss.dyn.i            = 0;
   stream->ss.dyn.repeat       = 0;
   stream->ss.dyn.prev         = 0;
+  stream->ss.dyn.tabs         = NULL;
   stream->ss.dyn.tlit_valid   = 0;
   stream->ss.dyn.tdist_valid  = 0;
   stream->ss.dyn.codelen_done = 0;
+
+  stream->nsegs = 0;
+  stream->nedge = 0;
 }
 
 UNZ_EXPORT
 void
 infl_reset(infl_stream_t * __restrict stream,
            void          * __restrict dst,
-           uint32_t                   dstlen,
+           size_t                     dstlen,
            int                        flags) {
   if (!stream)
     return;
 
   infl_reset_pool(stream);
-  stream->header = NULL;
-  stream->bitpos = 0;
-  stream->dst    = (uint8_t *)dst;
-  stream->dstlen = dstlen;
-  stream->dstpos = 0;
-  stream->flags  = flags;
+  stream->header  = NULL;
+  stream->bitpos  = 0;
+  stream->dstpos  = 0;
+  stream->flags   = flags;
+  stream->flushed = 0;
+  stream->slid    = 0;
+
+  stream->ntail    = 0;
+  stream->dropped  = 0;
+  stream->borrowed = false;
+
+  /* a sink, growable or iov stream keeps its buffer unless given a
+     destination, an iov stream drops its segments */
+  if (dst)
+    infl_drop_output(stream);
+
+  if (stream->shadow) {
+    stream->dst       = stream->shadow;
+    stream->dstlen    = 0;
+    stream->niov      = 0;
+    stream->iovi      = 0;
+    stream->iovoff    = 0;
+    stream->iovdone   = 0;
+    stream->iovdirect = false;
+  } else if (!stream->sink && !stream->grow) {
+    stream->dst    = (uint8_t *)dst;
+    stream->dstlen = dstlen;
+  }
 
   infl_reset_state(stream);
 }
@@ -278,8 +436,9 @@ UNZ_EXPORT
 int
 infl_resize_output(infl_stream_t * __restrict stream,
                    void          * __restrict dst,
-                   uint32_t                   dstlen) {
-  if (!stream || !dst || dstlen < stream->dstpos)
+                   size_t                     dstlen) {
+  if (!stream || stream->sink || stream->grow || stream->shadow
+      || !dst || dstlen < stream->dstpos)
     return UNZ_ERR;
 
   stream->dst    = (uint8_t *)dst;
@@ -287,14 +446,69 @@ infl_resize_output(infl_stream_t * __restrict stream,
   return UNZ_OK;
 }
 
+UNZ_HIDE
+bool
+infl_grow(defl_stream_t * __restrict stream) {
+  uint8_t *dst;
+  size_t   cap;
+
+  cap = stream->dstlen > SIZE_MAX / 2u ? SIZE_MAX : stream->dstlen * 2u;
+  if (cap < INFL_GROW_MIN)
+    cap = INFL_GROW_MIN;
+  if (cap == stream->dstlen || !(dst = infl_mem_realloc(stream, stream->dst, stream->dstlen, cap)))
+    return false;
+
+  stream->dst    = dst;
+  stream->dstlen = cap;
+  return true;
+}
+
 UNZ_EXPORT
-uint32_t
+uint8_t *
+infl_take_output(infl_stream_t * __restrict stream, size_t * __restrict len) {
+  uint8_t *dst;
+  size_t   n;
+
+  if (len) *len = 0;
+  if (!stream || !stream->grow)
+    return NULL;
+
+  /* the caller frees it with the size it has, so fit it to the output */
+  dst = stream->dst;
+  n   = stream->dstpos;
+  if (!n) {
+    infl_mem_free(stream, dst, stream->dstlen);
+    dst = NULL;
+  } else {
+    if (n < stream->dstlen) {
+      if (!(dst = infl_mem_realloc(stream, dst, stream->dstlen, n)))
+        return NULL;
+    }
+
+    /* no longer the stream's */
+    stream->meminuse -= n;
+    if (len) *len = n;
+  }
+
+  stream->dst    = NULL;
+  stream->dstlen = 0;
+  stream->grow   = false;
+  return dst;
+}
+
+UNZ_EXPORT
+size_t
 infl_output_pos(const infl_stream_t * __restrict stream) {
-  return stream ? (uint32_t)stream->dstpos : 0u;
+  if (!stream)
+    return 0u;
+  if (stream->shadow)
+    return stream->iovdone + stream->iovoff
+         + (stream->iovdirect ? 0u : stream->dstpos - stream->flushed);
+  return stream->slid + stream->dstpos;
 }
 
 UNZ_EXPORT
-uint32_t
+size_t
 infl_input_pos(const infl_stream_t * __restrict stream) {
   const unz_chunk_t *chunk;
   size_t pos;
@@ -303,7 +517,7 @@ infl_input_pos(const infl_stream_t * __restrict stream) {
   if (!stream || !stream->bs.chunk)
     return 0u;
 
-  pos = 0;
+  pos = stream->dropped;
   for (chunk = stream->start; chunk && chunk != stream->bs.chunk; chunk = chunk->next)
     pos += (size_t)(chunk->end - chunk->p);
 
@@ -325,37 +539,153 @@ infl_input_pos(const infl_stream_t * __restrict stream) {
   else
     pos = 0;
 
-  return pos > UINT32_MAX ? UINT32_MAX : (uint32_t)pos;
+  return pos;
+}
+
+/* infl_acquire(): released streams of this thread, with their pages, chunk
+   slabs and table cache */
+typedef struct infl_cache_t {
+  infl_stream_t *st[INFL_CACHE_MAX];
+  unsigned       n;
+  unsigned       depth;
+  bool           set;
+  bool           hooked;
+} infl_cache_t;
+
+static UNZ_TLS infl_cache_t infl_cache;
+
+static void
+infl_cache_drain(infl_cache_t *cache) {
+  while (cache->n)
+    infl_destroy(cache->st[--cache->n]);
+}
+
+/* a thread exit destroys the streams its cache holds: the key's value is the
+   exiting thread's cache, set once the cache first keeps a stream. the main
+   thread leaving through exit() runs no destructor, the process goes anyway */
+#ifdef _WIN32
+static INIT_ONCE infl_cache_once = INIT_ONCE_STATIC_INIT;
+static DWORD     infl_cache_key  = FLS_OUT_OF_INDEXES;
+
+static void WINAPI
+infl_cache_exit(void *cache) {
+  if (cache)
+    infl_cache_drain(cache);
+}
+
+static BOOL CALLBACK
+infl_cache_key_init(INIT_ONCE *once, void *param, void **ctx) {
+  (void)once; (void)param; (void)ctx;
+  infl_cache_key = FlsAlloc(infl_cache_exit);
+  return TRUE;
+}
+
+static void
+infl_cache_hook(void) {
+  InitOnceExecuteOnce(&infl_cache_once, infl_cache_key_init, NULL, NULL);
+  if (infl_cache_key != FLS_OUT_OF_INDEXES)
+    FlsSetValue(infl_cache_key, &infl_cache);
+  infl_cache.hooked = true;
+}
+#else
+static pthread_once_t infl_cache_once = PTHREAD_ONCE_INIT;
+static pthread_key_t  infl_cache_key;
+static bool           infl_cache_keyed;
+
+static void
+infl_cache_exit(void *cache) {
+  infl_cache_drain(cache);
+}
+
+static void
+infl_cache_key_init(void) {
+  infl_cache_keyed = pthread_key_create(&infl_cache_key, infl_cache_exit) == 0;
+}
+
+static void
+infl_cache_hook(void) {
+  pthread_once(&infl_cache_once, infl_cache_key_init);
+  if (infl_cache_keyed)
+    pthread_setspecific(infl_cache_key, &infl_cache);
+  infl_cache.hooked = true;
+}
+#endif
+
+UNZ_EXPORT
+infl_stream_t *
+infl_acquire(void * __restrict dst, size_t dstlen, int flags) {
+  infl_stream_t *st;
+
+  if (!infl_cache.n)
+    return infl_init(dst, dstlen, flags);
+
+  st = infl_cache.st[--infl_cache.n];
+  infl_reset(st, dst, dstlen, flags);
+  return st;
+}
+
+UNZ_EXPORT
+void
+infl_release(infl_stream_t * __restrict stream) {
+  unsigned depth;
+
+  if (!stream)
+    return;
+
+  depth = infl_cache.set ? infl_cache.depth : INFL_CACHE_DEPTH;
+
+  /* only plain streams on the default allocator are handed out again */
+  if (infl_cache.n >= depth || stream->sink || stream->grow || stream->shadow
+      || stream->mem.alloc != infl_libc.alloc) {
+    infl_destroy(stream);
+    return;
+  }
+
+  if (unlikely(!infl_cache.hooked))
+    infl_cache_hook();
+
+  infl_reset(stream, NULL, 0, 0);
+  infl_cache.st[infl_cache.n++] = stream;
+}
+
+UNZ_EXPORT
+void
+infl_cache_depth(unsigned depth) {
+  if (depth > INFL_CACHE_MAX)
+    depth = INFL_CACHE_MAX;
+
+  while (infl_cache.n > depth)
+    infl_destroy(infl_cache.st[--infl_cache.n]);
+
+  infl_cache.depth = depth;
+  infl_cache.set   = true;
 }
 
 UNZ_EXPORT
 void
 infl_destroy(defl_stream_t * __restrict stream) {
-  unz_chunk_t *chk, *tofree;
-  int i;
+  unz_chunk_page_t *pg;
+  unz_chunk_slab_t *slab;
+  infl_alloc_t      mem;
 
   if (!stream) return;
 
-  if ((chk = stream->start)) {
-    do {
-      tofree = chk;
-      chk    = chk->next;
-      
-      /* only free non-pooled chunks */
-      if (!tofree->is_pooled) { free(tofree); }
-    } while (chk);
+  /* only what was ever used is in the pools */
+  while ((pg = stream->pages)) {
+    stream->pages = pg->next;
+    infl_mem_free_aligned(stream, pg, sizeof(*pg));
   }
 
-  /* free appendable chunk pool */
-  for (i = 0; i < UNZ_CHUNK_POOL_SIZE; i++) {
-    if (stream->chunk_buffers[i]) ALIGNED_FREE(stream->chunk_buffers[i]);
-    if (stream->chunk_pool[i])    free(stream->chunk_pool[i]);
+  while ((slab = stream->slabs)) {
+    stream->slabs = slab->next;
+    infl_mem_free(stream, slab, sizeof(*slab));
   }
 
-  /* free chunk structure pool */
-  for (i = 0; i < UNZ_CHUNK_STRUCT_POOL_SIZE; i++) {
-    if (stream->chunk_struct_pool[i]) free(stream->chunk_struct_pool[i]);
-  }
+  infl_mem_free_aligned(stream, stream->ftcache, sizeof(*stream->ftcache));
+  infl_mem_free(stream, stream->segs, stream->segcap * sizeof(*stream->segs));
+  infl_mem_free(stream, stream->edge, stream->edgecap);
+  infl_drop_output(stream);
 
-  free(stream);
+  mem = stream->mem;
+  mem.free(mem.ctx, stream, sizeof(*stream));
 }
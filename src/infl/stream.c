@@ -15,7 +15,7 @@
  */
 
 #include "../common.h"
-#include "apicommon.h"
+#include "ft.h"
 
 #define UNFINISHED()                         DONATE();return UNZ_UNFINISHED;
 #define UNFINISHED_BLK() stream->dstpos=dpos;DONATE();return UNZ_UNFINISHED;
@@ -64,6 +64,8 @@
   return UNZ_EFULL;                                                            \
 } while (0)
 
+/* stored block, copied as far as the output goes: dstpos moves with every
+   byte so a block cut short by UNZ_EFULL or missing input resumes anywhere */
 static UNZ_HOT
 UnzResult
 infl_strm_raw(defl_stream_t   * __restrict stream,
@@ -71,7 +73,8 @@ infl_strm_raw(defl_stream_t   * __restrict stream,
   uint8_t        *dst;
   const uint8_t  *p;
   unz__bitstate_t bs;
-  unsigned        dpos, dlen, chkrem, n, remlen, i, simdlen, align;
+  size_t          dpos, dlen, chkrem, n, i, simdlen;
+  unsigned        remlen, align;
   uint32_t        header;
   uint16_t        len, nlen;
 
@@ -79,11 +82,9 @@ infl_strm_raw(defl_stream_t   * __restrict stream,
 
   bs = *bitstate;
 
-  dpos   = (unsigned)stream->dstpos;
+  dpos   = stream->dstpos;
   dlen   = stream->dstlen;
-  len    = stream->ss.raw.len;
   remlen = stream->ss.raw.remlen;
-  dst    = stream->dst + dpos + (len - remlen);
 
   if (!stream->ss.raw.resuming) {
     if (!stream->ss.raw.header_read) {
@@ -111,28 +112,32 @@ infl_strm_raw(defl_stream_t   * __restrict stream,
         DONATE();
         return UNZ_ERR;
       }
-
-      if (unlikely(dpos+len > dlen)) {
-        DONATE();
-        return UNZ_EFULL;
-      }
     }
   }
 
+  dst = stream->dst + dpos;
+
   while (remlen > 0 && bs.nbits + bs.npbits >= 8) {
+    if (unlikely(dpos >= dlen))
+      goto full;
     *dst++ = infl_take_byte(&bs);
+    dpos++;
     remlen--;
   }
 
   while (remlen > 0) {
+    if (unlikely(dpos >= dlen))
+      goto full;
+
     if (bs.p >= bs.end) {
       /* first check if current chunk was extended */
       if (bs.chunk == stream->end && stream->end->end > bs.end) {
         bs.end = stream->end->end;
       } else if (!bs.chunk || !bs.chunk->next || !bs.chunk->next->p || !bs.chunk->next->end) {
         /* no more data available - save state and return */
+        stream->dstpos          = dpos;
         stream->ss.raw.resuming = 1;
-        stream->ss.raw.remlen   = remlen;
+        stream->ss.raw.remlen   = (uint16_t)remlen;
         DONATE();
         return UNZ_UNFINISHED;
       } else {
@@ -144,10 +149,13 @@ infl_strm_raw(defl_stream_t   * __restrict stream,
     }
 
     p      = bs.p;
-    chkrem = (unsigned)(size_t)(bs.end - p);
+    chkrem = (size_t)(bs.end - p);
 
     if (likely(chkrem > 0)) {
       n = (chkrem < remlen) ? chkrem : remlen;
+      if (n > dlen - dpos)
+        n = dlen - dpos;
+      dpos += n;
 
 #if defined(__builtin_prefetch)
       if (n >= 256) {
@@ -163,7 +171,7 @@ infl_strm_raw(defl_stream_t   * __restrict stream,
         }
         p      += simdlen;
         dst    += simdlen;
-        remlen -= simdlen;
+        remlen -= (unsigned)simdlen;
         n      -= simdlen;
       }
 #elif defined(__AVX2__)
@@ -175,7 +183,7 @@ infl_strm_raw(defl_stream_t   * __restrict stream,
         }
         p      += simdlen;
         dst    += simdlen;
-        remlen -= simdlen;
+        remlen -= (unsigned)simdlen;
         n      -= simdlen;
       }
 #endif
@@ -201,14 +209,14 @@ infl_strm_raw(defl_stream_t   * __restrict stream,
         
         p      += n;
         dst    += n;
-        remlen -= n;
+        remlen -= (unsigned)n;
       }
       bs.p = p;
     }
   }
 
   /* successfully completed */
-  stream->dstpos             = dpos + len;
+  stream->dstpos             = dpos;
   stream->ss.raw.resuming    = 0;
   stream->ss.raw.align_done  = 0;
   stream->ss.raw.header_read = 0;
@@ -218,23 +226,70 @@ infl_strm_raw(defl_stream_t   * __restrict stream,
 
   *bitstate = bs;
   return UNZ_OK;
+
+full:
+  stream->dstpos          = dpos;
+  stream->ss.raw.resuming = 1;
+  stream->ss.raw.remlen   = (uint16_t)remlen;
+  DONATE();
+  return UNZ_EFULL;
+}
+
+/* hand the double-buffered reader over to the flat infl_ft reader: whole bytes
+   still in the back buffer are simply re-read from the chunk */
+UNZ_INLINE bool
+infl_strm_ft_enter(const unz__bitstate_t * __restrict bs,
+                   infl_ft_bits_t        * __restrict br) {
+  unsigned r;
+
+  r = bs->npbits & 7u;
+  if (bs->nbits + r > 63u)
+    return false;
+
+  br->chunk = bs->chunk;
+  br->p     = bs->p - (bs->npbits >> 3);
+  br->end   = bs->end;
+  br->bits  = bs->bits;
+  br->nbits = bs->nbits + r;
+  br->sp    = NULL;
+  br->lim   = NULL;
+  br->pad   = false; /* more input may still be appended */
+  if (r)
+    br->bits |= EXTRACT(bs->pbits, r) << bs->nbits;
+  return true;
+}
+
+UNZ_INLINE void
+infl_strm_ft_leave(unz__bitstate_t      * __restrict bs,
+                   const infl_ft_bits_t * __restrict br) {
+  bs->chunk  = br->chunk;
+  bs->p      = br->p;
+  bs->end    = br->end;
+  bs->bits   = br->bits;
+  bs->nbits  = br->nbits;
+  bs->pbits  = 0;
+  bs->npbits = 0;
 }
 
 static UNZ_HOT
 UnzResult
-infl_strm_blk(defl_stream_t          * __restrict stream,
-              unz__bitstate_t        * __restrict bitstate,
-              const huff_table_ext_t * __restrict tlit,
-              const huff_table_ext_t * __restrict tdist) {
+infl_strm_blk(defl_stream_t              * __restrict stream,
+              unz__bitstate_t            * __restrict bitstate,
+              const infl_ft_table_t      * __restrict tlit,
+              const infl_ft_dist_table_t * __restrict tdist) {
   uint8_t * __restrict dst;
   size_t  * __restrict dst_pos;
   unz__bitstate_t      bs;
+  infl_ft_bits_t       br;
   size_t               dst_cap, dpos;
-  unsigned             len, dist, src;
-  uint_fast16_t        lsym;
+  size_t               src;
+  unsigned             len, dist, total;
+  uint32_t             entry;
   uint8_t              used;
+  UnzResult            res;
   block_decode_state_t state;
-  unsigned             saved_len, saved_dist, saved_src, copy_remaining;
+  size_t               saved_src;
+  unsigned             saved_len, saved_dist, copy_remaining;
 
   dst     = stream->dst;
   dst_cap = stream->dstlen;
@@ -265,48 +320,64 @@ infl_strm_blk(defl_stream_t          * __restrict stream,
   }
 
   while (true) {
-    REFILL_STREAM_BLK(21);
+    /* bulk of the block: unchecked loop while the chunk and output allow it,
+       the careful per-symbol path below only handles the edges */
+    if ((size_t)(bs.end - bs.p) >= INFL_FT_FAST_IN
+        && dpos + INFL_FT_FAST_OUT <= dst_cap
+        && infl_strm_ft_enter(&bs, &br)) {
+      res = infl_ft_fast(&br, dst, &dpos, dst_cap, tlit, tdist);
+      infl_strm_ft_leave(&bs, &br);
+
+      if (res == UNZ_OK)
+        break;
 
-    if (likely(bs.nbits >= 21)) {
-      lsym = huff_decode_lsb_extof(tlit, bs.bits, &used, &len, 257);
-      if (unlikely(!used)) {
+      if (unlikely(res < UNZ_OK)) {
         *dst_pos = dpos;
         DONATE();
         return UNZ_ERR;
       }
-    } else {
-      lsym = huff_decode_lsb_extof_safe(tlit, bs.bits, (uint8_t)bs.nbits, &used, &len, 257);
-      if (!used) {
-        UNFINISHED_BLK();
-      }
     }
 
-    if (lsym > 285) {
-      *dst_pos = dpos;
-      DONATE();
-      return UNZ_ERR; /* invalid symbol */
+    REFILL_STREAM_BLK(20);
+
+    entry = infl_ft_lookup_lit(tlit, bs.bits);
+    total = INFL_FT_TOTAL(entry);
+
+    /* one literal at a time here, a pair's second code may not be in yet */
+    if ((entry & INFL_FT_LITERAL) && INFL_FT_LITCNT(entry) > 1)
+      total = INFL_FT_CODELEN(entry);
+
+    if (unlikely(!entry || total > bs.nbits)) {
+      if (!entry && bs.nbits >= 15) {
+        *dst_pos = dpos;
+        DONATE();
+        return UNZ_ERR; /* invalid symbol */
+      }
+      UNFINISHED_BLK();
     }
 
-    if (lsym < 256) {
+    if (entry & INFL_FT_LITERAL) {
       /* literal byte */
       if (unlikely(dpos >= dst_cap)) {
         *dst_pos = dpos;
         DONATE();
         return UNZ_EFULL;
       }
-      CONSUME(used);
-      dst[dpos++] = (uint8_t)lsym;
+      CONSUME(total);
+      dst[dpos++] = (uint8_t)INFL_FT_BASE(entry);
 
       /* clear state after successful literal */
       stream->ss.blk.state = BLOCK_STATE_NONE;
       continue;
-    } else if (unlikely(lsym == 256)) {
+    } else if (unlikely(entry & INFL_FT_END)) {
       /* eof */
-      CONSUME(used);
+      CONSUME(total);
       break;
     }
 
-    CONSUME(used);
+    len = INFL_FT_BASE(entry)
+        + (unsigned)(EXTRACT(bs.bits, total) >> INFL_FT_CODELEN(entry));
+    CONSUME(total);
 
     stream->ss.blk.state = BLOCK_STATE_LENGTH;
     stream->ss.blk.len   = len;
@@ -317,31 +388,31 @@ infl_strm_blk(defl_stream_t          * __restrict stream,
     }
 
   distance:
-    REFILL_STREAM_BLK(29);
+    REFILL_STREAM_BLK(28);
 
-    if (likely(bs.nbits >= 29)) {
-      dist = huff_decode_lsb_ext(tdist, bs.bits, &used);
-      if (unlikely(!used)) {
+    entry = infl_ft_lookup_dist(tdist, bs.bits);
+    total = INFL_FT_TOTAL(entry);
+    if (unlikely(!entry || total > bs.nbits)) {
+      if (!entry && bs.nbits >= 15) {
         *dst_pos = dpos;
         DONATE();
         return UNZ_ERR;
       }
-    } else {
-      dist = huff_decode_lsb_ext_safe(tdist, bs.bits, (uint8_t)bs.nbits, &used);
-      if (!used) {
-        UNFINISHED_BLK();
-      }
+      UNFINISHED_BLK();
     }
 
+    dist = INFL_FT_BASE(entry)
+         + (unsigned)(EXTRACT(bs.bits, total) >> INFL_FT_CODELEN(entry));
+
     if (unlikely((size_t)(dist - 1) >= dpos)) {
       *dst_pos = dpos;
       DONATE();
       return UNZ_ERR; /* validate distance */
     }
 
-    CONSUME(used);
+    CONSUME(total);
 
-    src = (unsigned)(dpos - dist);
+    src = dpos - dist;
 
   /* backref: */
     /* save state for potential pause */
@@ -465,14 +536,13 @@ infl_strm_blk(defl_stream_t          * __restrict stream,
 #undef FULL_BLK
 #undef OUT_FULL
 
-UNZ_EXPORT
-int
-infl_stream(infl_stream_t * __restrict stream,
-            const void    * __restrict src,
-            uint32_t                   srclen) {
-  static huff_table_ext_t _tlitl_s={0},_tdist_s={0};
-  static bool             _init_s=false;
-
+/* all: inflate the included chunks even if nothing new is given, infl() and
+   the sink loop resuming after UNZ_EFULL */
+static int
+infl_strm_run(infl_stream_t * __restrict stream,
+              const void    * __restrict src,
+              size_t                     srclen,
+              bool                       all) {
   unz__bitstate_t bs;
   uint_fast8_t    btype, bfinal=0;
   UnzResult       res;
@@ -503,18 +573,9 @@ infl_stream(infl_stream_t * __restrict stream,
     goto noop;
 
   /* if no data and not in middle of processing, return NOOP */
-  if (!src && srclen == 0 && stream->ss.state == INFL_STATE_NONE)
+  if (!all && !src && srclen == 0 && stream->ss.state == INFL_STATE_NONE)
     goto noop;
 
-  /* initialize static tables for streaming */
-  if (!_init_s) {
-    if (!huff_init_lsb_extof(&_tlitl_s,fxd,NULL,lvals,257,288) ||
-        !huff_init_lsb_ext(&_tdist_s,fxd+288,NULL,dvals,32)) {
-      goto err;
-    }
-    _init_s = true;
-  }
-
   /* resume from saved state */
   if (stream->ss.state != INFL_STATE_NONE) {
     bfinal = stream->ss.bfinal;
@@ -547,7 +608,7 @@ infl_stream(infl_stream_t * __restrict stream,
   RESTORE();
 
 hdr:
-  if (stream->flags == 1 && unlikely(!stream->header) && !stream->ss.gothdr) {
+  if ((stream->flags & INFL_ZLIB) && unlikely(!stream->header) && !stream->ss.gothdr) {
     unz_chunk_t *tmp;
     size_t       avail;
 
@@ -621,7 +682,7 @@ raw:
 fixed:
         stream->ss.state = INFL_STATE_FIXED;
         {
-          res = infl_strm_blk(stream, &bs, &_tlitl_s, &_tdist_s);
+          res = infl_strm_blk(stream, &bs, &infl_ft_fixed_lit, &infl_ft_fixed_dist);
           if (res == UNZ_UNFINISHED) return UNZ_UNFINISHED;
           if (res == UNZ_EFULL)      return UNZ_EFULL;
           if (res < UNZ_OK)          goto   err;
@@ -630,7 +691,7 @@ fixed:
       case 2: {
         huff_fast_entry_t tcodelen[HUFF_FAST_TABLE_SIZE] = {0};
         huff_fast_entry_t fe;
-        int               i, n, hclen, hlit, hdist, repeat, prev;
+        int               i, n, hclen, hlit, hdist, repeat, prev, fill;
 
         if (stream->ss.state == INFL_STATE_DYNAMIC_BLOCK) {
           goto dyn_blk;
@@ -729,10 +790,10 @@ fixed:
               }
 
               /* fill repeat values */
-              while (repeat > 0 && i < n) {
-                stream->ss.dyn.lens[i++] = prev;
-                repeat--;
-              }
+              fill = repeat < n - i ? repeat : n - i;
+              memset(stream->ss.dyn.lens + i, prev, (size_t)fill);
+              i      += fill;
+              repeat -= fill;
 
               /* update or clear repeat state */
               if (repeat > 0) {
@@ -756,15 +817,16 @@ fixed:
         }
 
         /* build literal/length and distance tables */
-        if (!huff_init_lsb_extof(&stream->ss.dyn.tlit,stream->ss.dyn.lens,NULL,lvals,257,hlit) ||
-            !huff_init_lsb_ext(&stream->ss.dyn.tdist, stream->ss.dyn.lens+hlit,NULL,dvals,hdist))
+        if (!(stream->ss.dyn.tabs = infl_ft_dyn_tables(stream, stream->ss.dyn.lens,
+                                                       (unsigned)hlit, (unsigned)hdist)))
           goto err;
 
       dyn_blk:
         stream->ss.state = INFL_STATE_DYNAMIC_BLOCK;
 
         /* decode the compressed block */
-        res = infl_strm_blk(stream, &bs, &stream->ss.dyn.tlit, &stream->ss.dyn.tdist);
+        res = infl_strm_blk(stream, &bs, &stream->ss.dyn.tabs->tlit,
+                            &stream->ss.dyn.tabs->tdist);
 
         if (res == UNZ_UNFINISHED) return UNZ_UNFINISHED;
         if (res == UNZ_EFULL)      return UNZ_EFULL;
@@ -792,3 +854,346 @@ err:
   stream->ss.state = INFL_STATE_NONE;  /* reset on error */
   return UNZ_ERR;
 }
+
+/* sink output: hand over whole slices up to dstpos, the rest too at the end */
+static int
+infl_sink_flush(defl_stream_t * __restrict stream, bool end) {
+  size_t n;
+  int    ret;
+
+  while ((n = stream->dstpos - stream->flushed) >= stream->slice
+         || (end && n)) {
+    if (n > stream->slice)
+      n = stream->slice;
+    if ((ret = stream->sink(stream->sinkctx, stream->dst + stream->flushed, n)) != UNZ_OK)
+      return ret;
+    stream->flushed += n;
+  }
+  return UNZ_OK;
+}
+
+/*
+ * sink output after UNZ_EFULL: move the last window and whatever is not handed
+ * over yet to the front, so matches keep reading one flat buffer and the copy
+ * kernels never see a wrap. only called on UNZ_EFULL, where nothing is written
+ * past dstpos. the buffer has INFL_SINK_SLACK bytes beyond window + slice, as
+ * much as the longest match needs, so a slide always makes enough room
+ */
+static bool
+infl_sink_slide(defl_stream_t * __restrict stream) {
+  size_t k;
+
+  k = stream->dstpos > INFL_WINDOW ? stream->dstpos - INFL_WINDOW : 0;
+  if (k > stream->flushed)
+    k = stream->flushed;
+  if (!k)
+    return false;
+
+  memmove(stream->dst, stream->dst + k, stream->dstpos - k);
+  stream->dstpos  -= k;
+  stream->flushed -= k;
+  stream->slid    += k;
+  if (stream->ss.blk.state == BLOCK_STATE_BACKREF)
+    stream->ss.blk.src -= k;
+  return true;
+}
+
+/* iov output: copy what the shadow holds past flushed to the segments, or
+   note how far the segment written in place got. false if they ran out */
+static bool
+infl_iov_collect(defl_stream_t * __restrict stream) {
+  const infl_iov_t *v;
+  size_t            n;
+
+  if (stream->iovdirect) {
+    stream->iovoff = stream->dstpos;
+    return true;
+  }
+
+  while (stream->flushed < stream->dstpos) {
+    if (stream->iovi >= stream->niov)
+      return false;
+
+    v = &stream->iov[stream->iovi];
+    n = stream->dstpos - stream->flushed;
+    if (n > v->len - stream->iovoff)
+      n = v->len - stream->iovoff;
+
+    memcpy((uint8_t *)v->base + stream->iovoff, stream->shadow + stream->flushed, n);
+    stream->flushed += n;
+    stream->iovoff  += n;
+    if (stream->iovoff == v->len) {
+      stream->iovdone += v->len;
+      stream->iovoff   = 0;
+      stream->iovi++;
+    }
+  }
+  return true;
+}
+
+/*
+ * iov output after UNZ_EFULL: keep the last window in the shadow, then pick
+ * where the next bytes go. a segment that already holds a window of output is
+ * written in place, matches in it never reach back past its start. otherwise
+ * the shadow takes the bytes up to that point and they are copied out, so each
+ * segment costs at most about two windows of copying. false if the segments
+ * ran out
+ */
+static bool
+infl_iov_next(defl_stream_t * __restrict stream) {
+  const infl_iov_t *v;
+  size_t            k, want;
+
+  if (stream->iovdirect) {
+    v = &stream->iov[stream->iovi];
+    memcpy(stream->shadow, (uint8_t *)v->base + stream->iovoff - INFL_WINDOW, INFL_WINDOW);
+    stream->dst       = stream->shadow;
+    stream->dstpos    = INFL_WINDOW;
+    stream->flushed   = INFL_WINDOW;
+    stream->iovdirect = false;
+    if (stream->iovoff == v->len) {
+      stream->iovdone += v->len;
+      stream->iovoff   = 0;
+      stream->iovi++;
+    }
+  } else {
+    if (stream->flushed < stream->dstpos)
+      return false;
+
+    k = stream->dstpos > INFL_WINDOW ? stream->dstpos - INFL_WINDOW : 0;
+    if (k)
+      memmove(stream->shadow, stream->shadow + k, stream->dstpos - k);
+    stream->dstpos -= k;
+    stream->flushed = stream->dstpos;
+  }
+
+  while (stream->iovi < stream->niov && !stream->iov[stream->iovi].len)
+    stream->iovi++;
+
+  if (stream->iovi >= stream->niov) {
+    stream->dstlen = stream->dstpos;
+    return false;
+  }
+
+  v = &stream->iov[stream->iovi];
+  if (stream->iovoff >= INFL_WINDOW && v->len - stream->iovoff > INFL_SINK_SLACK) {
+    stream->dst       = v->base;
+    stream->dstlen    = v->len;
+    stream->dstpos    = stream->iovoff;
+    stream->iovdirect = true;
+  } else {
+    /* up to where the segment can be written in place, else a window's worth
+       so small segments are filled many per pass. never less than a match */
+    want = stream->iovoff < INFL_WINDOW && v->len > INFL_WINDOW
+         ? INFL_WINDOW - stream->iovoff
+         : INFL_WINDOW;
+    if (want < INFL_SINK_SLACK)
+      want = INFL_SINK_SLACK;
+    stream->dstlen = stream->dstpos + want;
+  }
+
+  if (stream->ss.blk.state == BLOCK_STATE_BACKREF)
+    stream->ss.blk.src = stream->dstpos - stream->ss.blk.dist;
+  return true;
+}
+
+UNZ_HIDE
+int
+infl_strm_drive(infl_stream_t * __restrict stream,
+                const void    * __restrict src,
+                size_t                     srclen,
+                bool                       all) {
+  int res, ret;
+
+  res = infl_strm_run(stream, src, srclen, all);
+
+  if (stream->shadow) {
+    for (;;) {
+      if (res < UNZ_OK && res != UNZ_EFULL)
+        return res;
+      if (!infl_iov_collect(stream))
+        return UNZ_EFULL;
+      if (res != UNZ_EFULL)
+        return res;
+      if (!infl_iov_next(stream))
+        return UNZ_EFULL;
+      res = infl_strm_run(stream, NULL, 0, true);
+    }
+  }
+
+  if (stream->grow) {
+    while (res == UNZ_EFULL) {
+      if (unlikely(!infl_grow(stream)))
+        return UNZ_ENOMEM;
+      res = infl_strm_run(stream, NULL, 0, true);
+    }
+    return res;
+  }
+
+  if (!stream->sink)
+    return res;
+
+  while (res == UNZ_EFULL) {
+    if ((ret = infl_sink_flush(stream, false)) != UNZ_OK)
+      return ret;
+    if (unlikely(!infl_sink_slide(stream)))
+      return UNZ_EFULL;
+    res = infl_strm_run(stream, NULL, 0, true);
+  }
+
+  if (res == UNZ_OK || res == UNZ_UNFINISHED) {
+    if ((ret = infl_sink_flush(stream, res == UNZ_OK)) != UNZ_OK)
+      return ret;
+  }
+  return res;
+}
+
+UNZ_EXPORT
+int
+infl_stream(infl_stream_t * __restrict stream,
+            const void    * __restrict src,
+            size_t                     srclen) {
+  if (stream->borrowed)
+    return UNZ_EPERM;
+  return infl_strm_drive(stream, src, srclen, false);
+}
+
+/* infl_stream_borrow(): link tail and src for one call, the reader continues
+   where it stopped in tail */
+static void
+infl_borrow_link(infl_stream_t * __restrict stream,
+                 const uint8_t * __restrict src,
+                 size_t                     srclen) {
+  unz_chunk_t *tc, *sc;
+  size_t       skip;
+
+  tc   = &stream->tailchk;
+  sc   = &stream->srcchk;
+  skip = stream->bs.chunk == tc ? (size_t)(stream->bs.p - stream->tail) : 0u;
+
+  memset(tc, 0, sizeof(*tc));
+  memset(sc, 0, sizeof(*sc));
+  tc->p    = stream->tail;
+  tc->end  = stream->tail + stream->ntail;
+  tc->used = stream->ntail;
+  sc->p    = src;
+  sc->end  = srclen ? src + srclen : src;
+  sc->used = srclen;
+
+  stream->current_appendable = NULL;
+  stream->srclen             = stream->ntail + srclen;
+
+  if (stream->ntail || !srclen) {
+    tc->next          = srclen ? sc : NULL;
+    stream->start     = tc;
+    stream->end       = srclen ? sc : tc;
+    stream->bs.chunk  = tc;
+    stream->bs.p      = tc->p + skip;
+    stream->bs.end    = tc->end;
+  } else {
+    stream->start     = sc;
+    stream->end       = sc;
+    stream->bs.chunk  = sc;
+    stream->bs.p      = sc->p;
+    stream->bs.end    = sc->end;
+  }
+}
+
+/* infl_stream_borrow(): keep what the reader still needs of the input in tail,
+   returns how much of src was taken */
+static size_t
+infl_borrow_keep(infl_stream_t * __restrict stream,
+                 const uint8_t * __restrict src,
+                 size_t                     srclen,
+                 int                        res) {
+  const unz_chunk_t *c;
+  const uint8_t     *q, *p;
+  uint8_t            keep[INFL_BORROW_TAIL];
+  size_t             n, from, skip, back, adv;
+
+  c    = stream->bs.chunk;
+  p    = stream->bs.p;
+  n    = 0;
+  from = 0;
+  skip = 0;
+  adv  = stream->ntail;
+
+  if (res == UNZ_OK) {
+    /* done, what is left in the bit buffer is past the end */
+    back = (stream->bs.nbits + stream->bs.npbits) >> 3;
+    if (c == &stream->srcchk)
+      from = (size_t)(p - src) > back ? (size_t)(p - src) - back : 0u;
+    else if (c == &stream->tailchk)
+      adv  = (size_t)(p - stream->tail) > back ? (size_t)(p - stream->tail) - back : 0u;
+    stream->bs.bits   = 0;
+    stream->bs.nbits  = 0;
+    stream->bs.pbits  = 0;
+    stream->bs.npbits = 0;
+  } else if (c == &stream->tailchk || c == &stream->srcchk) {
+    /* the whole bytes in the back buffer are read again from the chunk */
+    skip = stream->bs.npbits >> 3;
+    q    = p - skip;
+    if (c == &stream->tailchk) {
+      n = (size_t)(c->end - q);
+    } else {
+      n    = skip;
+      from = (size_t)(p - src);
+    }
+    memcpy(keep, q, n);
+
+    /* a short rest is kept too, so all of src can be released */
+    if ((res == UNZ_UNFINISHED || res == UNZ_EFULL)
+        && srclen - from <= sizeof(keep) - n) {
+      memcpy(keep + n, src + from, srclen - from);
+      n   += srclen - from;
+      from = srclen;
+    }
+  }
+
+  memcpy(stream->tail, keep, n);
+  stream->dropped += adv + from - n;
+  stream->ntail    = n;
+
+  memset(&stream->tailchk, 0, sizeof(stream->tailchk));
+  stream->tailchk.p    = stream->tail;
+  stream->tailchk.end  = stream->tail + n;
+  stream->tailchk.used = n;
+  stream->start        = &stream->tailchk;
+  stream->end          = &stream->tailchk;
+  stream->srclen       = n;
+  stream->bs.chunk     = &stream->tailchk;
+  stream->bs.p         = stream->tail + skip;
+  stream->bs.end       = stream->tailchk.end;
+
+  return from;
+}
+
+UNZ_EXPORT
+int
+infl_stream_borrow(infl_stream_t * __restrict stream,
+                   const void    * __restrict src,
+                   size_t                     srclen,
+                   size_t        * __restrict consumed) {
+  size_t from;
+  int    res;
+
+  if (consumed)
+    *consumed = 0;
+  if (!stream || (srclen && !src))
+    return UNZ_ERR;
+
+  /* chunks of infl_include() would be dropped with the chain */
+  if (!stream->borrowed) {
+    if (stream->start)
+      return UNZ_EPERM;
+    stream->borrowed = true;
+  }
+
+  infl_borrow_link(stream, (const uint8_t *)src, srclen);
+  res  = infl_strm_drive(stream, NULL, 0, true);
+  from = infl_borrow_keep(stream, (const uint8_t *)src, srclen, res);
+
+  if (consumed)
+    *consumed = from;
+  return res;
+}
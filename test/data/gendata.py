@@ -67,6 +67,19 @@ def compress_file(input_path, output_path):
             # Use uncompressed DEFLATE blocks
             compressed = create_uncompressed_deflate(data)
             compression_type = "uncompressed"
+        elif filename.startswith('huffman_only_'):
+            # Literal-only dynamic blocks (no matches)
+            comp = zlib.compressobj(6, zlib.DEFLATED, -15, 8, zlib.Z_HUFFMAN_ONLY)
+            compressed = comp.compress(data) + comp.flush()
+            compression_type = "huffman-only"
+        elif filename.startswith('full_flush_'):
+            # Full flush every 2KB: consecutive dynamic blocks repeat a header
+            comp = zlib.compressobj(9, zlib.DEFLATED, -15)
+            compressed = b""
+            for i in range(0, len(data), 2048):
+                compressed += comp.compress(data[i:i + 2048]) + comp.flush(zlib.Z_FULL_FLUSH)
+            compressed += comp.flush()
+            compression_type = "full-flush"
         else:
             # Use zlib.compress with DEFLATE format (no header/trailer)
             # wbits=-15 means raw DEFLATE without zlib header
@@ -520,6 +533,53 @@ int main(int argc, char *argv[]) {
     write_file("uncompressed_alternating", bytes(i & 0xFF for i in range(1000)))  # Binary pattern uncompressed
     write_file("uncompressed_text", "This is uncompressed text that will be stored as-is in DEFLATE blocks." * 50)
 
+    # 35. Literal-only blocks with a skewed alphabet (short literal codes)
+    rng = random.Random(0x11735)
+    digits = bytes(rng.choices(b"0123456789,\n", weights=[30, 20, 12, 8, 6, 5, 4, 3, 3, 3, 4, 2], k=32768))
+    write_file("huffman_only_digits", digits)
+
+    # 36. Short-period data (RGB/RGBA pixels, UTF-16 text): long matches at
+    # distances 2..7 with an occasional break in the pattern
+    rng = random.Random(0x5407)
+    for period in range(2, 8):
+        data = bytearray()
+        while len(data) < 16384:
+            data += bytes(rng.randrange(256) for _ in range(period)) * rng.randrange(4, 120)
+        write_file(f"period_{period}", data)
+
+    # 37. Many dynamic blocks with identical code lengths (repeated records)
+    record = b"".join(b"id=%04d status=ok bytes=%05d path=/img/tile_%02d.png\n"
+                      % (i, i * 37 % 99991, i % 64) for i in range(40))
+    write_file("full_flush_records", record[:2048] * 64)
+
+    # 38. Match-heavy data: short distances 1..512 and random ones up to 4096,
+    # with a few literals between the matches
+    rng = random.Random(0xBAC)
+    data = bytearray(rng.randrange(256) for _ in range(4096))
+    while len(data) < 262144:
+        if rng.randrange(8) == 0:
+            data += bytes(rng.randrange(256) for _ in range(rng.randrange(1, 8)))
+            continue
+        if rng.randrange(4):
+            dist = rng.choice((1, 2, 3, 4, 8, 16, 32, 64, 128, 256, 512))
+        else:
+            dist = rng.randrange(1, 4097)
+        for _ in range(rng.randrange(3, 40)):
+            data.append(data[-dist])
+    write_file("backref_mix", data)
+
+    # 39. Stored blocks followed by huffman blocks that copy from them
+    rng = random.Random(38)
+    noise = bytes(rng.randrange(256) for _ in range(20000))
+    text = b"stored and huffman blocks share one window. " * 100
+    write_file("stored_mix_window",
+               noise + text + noise[-6000:] + text[:1000] + noise[:3000] + text)
+
+    # 40. Huffman blocks far longer than the INFL_NOCACHE eviction batch
+    lines = b"".join(b"%08d GET /static/app.js 200 text/javascript cache=hit\n"
+                     % (i * 7919 % 100000000) for i in range(64))
+    write_file("long_blocks_1m", lines * 320)
+
 def compress_all_files():
     """Compress all files from raw/ to compressed/"""
     # Get current working directory and paths
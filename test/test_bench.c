@@ -0,0 +1,752 @@
+/*
+ * Copyright (C) 2025 Recep Aslantas
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * decode benchmarks over the test corpus, run from test/ like test_files.
+ * every case prints best-of-rounds numbers per input. most decode options are
+ * compile time, so compare two builds of the library:
+ *
+ *   tables   dynamic blocks from small to full alphabets, table build width.
+ *            -DCMAKE_C_FLAGS=-DINFL_FT_BUILD_MIN=10 builds every table at full
+ *            width
+ *   matches  match-heavy data, length/distance entries with the extra bits
+ *            folded in. -DCMAKE_C_FLAGS=-DINFL_FT_PREXBITS=0 turns that off
+ *   far      64 MiB of output made mostly of 8-32 KiB back copies, generated
+ *            here as one fixed huffman block. -DDEFL_FT_PREFETCH=8192
+ *            prefetches their sources
+ *   nocache  64 MiB of stored and of huffman output with INFL_NOCACHE off and
+ *            on, while another thread scans a buffer that fits the caches.
+ *            the scan rate shows how much of the cache the decode takes
+ *   streams  bytes held by a stream with a short payload and the latency of
+ *            infl_init() + infl_destroy(), with and without a decode
+ *   acquire  decode latency of 100 B - 4 KB inputs on a new stream, a stream
+ *            from infl_acquire() and infl_once()
+ *
+ * usage: test_bench [-r rounds] [case ...], all cases without one. exits
+ * nonzero if an input does not decode
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include <defl/infl.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#include <pthread.h>
+#endif
+
+#define ARRAY_LEN(ARR) (sizeof(ARR) / sizeof(ARR[0]))
+
+/* a round repeats its decode for at least this long */
+#define BENCH_ROUND_TIME 0.02
+
+static int  g_rounds = 5;
+static bool g_failed;
+
+static double
+get_time(void) {
+#ifdef _WIN32
+  LARGE_INTEGER frequency, counter;
+  QueryPerformanceFrequency(&frequency);
+  QueryPerformanceCounter(&counter);
+  return (double)counter.QuadPart / frequency.QuadPart;
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1000000000.0;
+#endif
+}
+
+static uint8_t*
+read_file(const char *path, size_t *size) {
+  FILE    *f;
+  uint8_t *data;
+
+  if (!(f = fopen(path, "rb")))
+    return NULL;
+
+  fseek(f, 0, SEEK_END);
+  *size = ftell(f);
+  fseek(f, 0, SEEK_SET);
+
+  if (!(data = malloc(*size ? *size : 1))) {
+    fclose(f);
+    return NULL;
+  }
+
+  if (fread(data, 1, *size, f) != *size) {
+    free(data);
+    fclose(f);
+    return NULL;
+  }
+
+  fclose(f);
+  return data;
+}
+
+typedef struct bench_input_t {
+  uint8_t *raw, *comp, *out;
+  size_t   rawlen, complen, outlen;
+} bench_input_t;
+
+/* raw and compressed data of a test file, decoded once to check it */
+static bool
+bench_load(const char *filename, bench_input_t *in) {
+  char path[512];
+
+  memset(in, 0, sizeof(*in));
+
+  snprintf(path, sizeof(path), "data/raw/%s", filename);
+  if (!(in->raw = read_file(path, &in->rawlen)))
+    goto skip;
+
+  snprintf(path, sizeof(path), "data/compressed/%s", filename);
+  if (!(in->comp = read_file(path, &in->complen)))
+    goto skip;
+
+  in->outlen = in->rawlen + 1000;
+  if (!(in->out = malloc(in->outlen)))
+    goto skip;
+
+  if (infl_buf(in->comp, in->complen, in->out, in->outlen, 0) != UNZ_OK
+      || memcmp(in->raw, in->out, in->rawlen) != 0) {
+    fprintf(stderr, "  %-24s decode failed\n", filename);
+    g_failed = true;
+    goto skip;
+  }
+  return true;
+
+skip:
+  free(in->raw);
+  free(in->comp);
+  free(in->out);
+  return false;
+}
+
+static void
+bench_unload(bench_input_t *in) {
+  free(in->raw);
+  free(in->comp);
+  free(in->out);
+}
+
+/* best seconds per call of fn over g_rounds rounds */
+static double
+bench_best(void (*fn)(void *arg), void *arg) {
+  double best, start, elapsed;
+  size_t n, calls, batch;
+  int    round;
+
+  best = 0.0;
+  for (round = 0; round < g_rounds; round++) {
+    calls = 0;
+    batch = 1;
+    start = get_time();
+    do {
+      for (n = 0; n < batch; n++)
+        fn(arg);
+      calls  += batch;
+      batch   = batch < 64 ? batch * 2 : batch;
+      elapsed = get_time() - start;
+    } while (elapsed < BENCH_ROUND_TIME);
+
+    elapsed /= (double)calls;
+    if (!round || elapsed < best)
+      best = elapsed;
+  }
+  return best;
+}
+
+static void
+bench_buf_run(void *arg) {
+  bench_input_t *in = arg;
+  infl_buf(in->comp, in->complen, in->out, in->outlen, 0);
+}
+
+/* infl_buf() throughput of test files, in MB/s of output */
+static void
+bench_files(const char * const files[]) {
+  bench_input_t in;
+  double        sec;
+  size_t        i;
+
+  for (i = 0; files[i]; i++) {
+    if (!bench_load(files[i], &in))
+      continue;
+
+    sec = bench_best(bench_buf_run, &in);
+    printf("  %-24s %9zu B  %8.1f MB/s\n", files[i], in.rawlen,
+           (double)in.rawlen / sec / 1e6);
+    bench_unload(&in);
+  }
+}
+
+/* dynamic blocks with few symbols build narrow tables, full alphabets build
+   at the main table width and use subtables */
+static void
+bench_tables(void) {
+  static const char * const files[] = {
+    "huffman_two_symbols", "huffman_skewed", "huffman_only_digits",
+    "dynamic_huffman_2", "c_source", "csv_data", "css_content", "xml_content",
+    "log_pattern", "png_simulation", "huffman_all_bytes", "compress_poor",
+    NULL
+  };
+
+  bench_files(files);
+}
+
+/* mostly matches: one lookup and one add per length or distance when the
+   extra bits are folded into the entry */
+static void
+bench_matches(void) {
+  static const char * const files[] = {
+    "backref_mix", "backref_1", "backref_8", "backref_64", "backref_512",
+    "match_len_3", "match_len_258", "distance_test_8192", "lz77_good", NULL
+  };
+
+  bench_files(files);
+}
+
+/* fixed huffman writer for generated inputs, rfc 1951 3.2.5 and 3.2.6 */
+typedef struct bench_bits_t {
+  uint8_t  *p;
+  uint64_t  acc;
+  unsigned  n;
+} bench_bits_t;
+
+static const uint16_t bench_lbase[29] = {
+  3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59,
+  67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const uint8_t bench_lext[29] = {
+  0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4,
+  5, 5, 5, 5, 0
+};
+static const uint16_t bench_dbase[30] = {
+  1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513,
+  769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+static const uint8_t bench_dext[30] = {
+  0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10,
+  11, 11, 12, 12, 13, 13
+};
+
+static void
+bench_put(bench_bits_t *bw, uint32_t v, unsigned n) {
+  bw->acc |= (uint64_t)v << bw->n;
+  bw->n   += n;
+  while (bw->n >= 8) {
+    *bw->p++  = (uint8_t)bw->acc;
+    bw->acc >>= 8;
+    bw->n    -= 8;
+  }
+}
+
+/* huffman codes go out msb first */
+static void
+bench_put_code(bench_bits_t *bw, uint32_t code, unsigned n) {
+  uint32_t rev;
+  unsigned i;
+
+  for (rev = 0, i = 0; i < n; i++)
+    rev |= ((code >> i) & 1u) << (n - 1u - i);
+  bench_put(bw, rev, n);
+}
+
+static void
+bench_put_sym(bench_bits_t *bw, unsigned sym) {
+  if      (sym < 144) bench_put_code(bw, 0x30u + sym,          8);
+  else if (sym < 256) bench_put_code(bw, 0x190u + sym - 144u,  9);
+  else if (sym < 280) bench_put_code(bw, sym - 256u,           7);
+  else                bench_put_code(bw, 0xc0u + sym - 280u,   8);
+}
+
+static void
+bench_put_match(bench_bits_t *bw, unsigned len, unsigned dist) {
+  unsigned i;
+
+  for (i = 28; bench_lbase[i] > len; i--) ;
+  bench_put_sym(bw, 257u + i);
+  bench_put(bw, len - bench_lbase[i], bench_lext[i]);
+
+  for (i = 29; bench_dbase[i] > dist; i--) ;
+  bench_put_code(bw, i, 5);
+  bench_put(bw, dist - bench_dbase[i], bench_dext[i]);
+}
+
+static uint32_t
+bench_rand(uint32_t *state) {
+  *state = *state * 1103515245u + 12345u;
+  return *state >> 8;
+}
+
+/* log-like output where about 85% of the bytes are copies from 8-32 KiB back,
+   the sources are cold once the output outgrows the caches */
+static bool
+bench_far_make(bench_input_t *in, size_t size) {
+  bench_bits_t bw;
+  uint32_t     rng;
+  size_t       pos, end;
+  unsigned     len, dist, lits;
+
+  memset(in, 0, sizeof(*in));
+  in->rawlen = size;
+  in->outlen = size + 1000;
+  if (!(in->raw  = malloc(size + 258))
+      || !(in->out  = malloc(in->outlen))
+      || !(in->comp = malloc(size / 2 + 64))) {
+    bench_unload(in);
+    return false;
+  }
+
+  memset(&bw, 0, sizeof(bw));
+  bw.p = in->comp;
+  rng  = 0x13u;
+  pos  = 0;
+
+  bench_put(&bw, 1, 1); /* BFINAL */
+  bench_put(&bw, 1, 2); /* fixed codes */
+
+  while (pos < size) {
+    lits = pos < 32768 ? 64 : bench_rand(&rng) % 48;
+    for (end = pos + lits; pos < end && pos < size; pos++) {
+      in->raw[pos] = (uint8_t)(' ' + bench_rand(&rng) % 95);
+      bench_put_sym(&bw, in->raw[pos]);
+    }
+    if (pos < 32768 || pos >= size)
+      continue;
+
+    len  = 3 + bench_rand(&rng) % 256;
+    dist = 8192 + bench_rand(&rng) % (32768 - 8192);
+    if (len > size - pos)
+      len = (unsigned)(size - pos);
+    if (len < 3)
+      len = 3; /* raw has room for the overshoot */
+    bench_put_match(&bw, len, dist);
+    for (end = pos + len; pos < end; pos++)
+      in->raw[pos] = in->raw[pos - dist];
+  }
+
+  in->rawlen = pos;
+  bench_put_sym(&bw, 256);
+  bench_put(&bw, 0, 7);
+  in->complen = (size_t)(bw.p - in->comp);
+
+  if (infl_buf(in->comp, in->complen, in->out, in->outlen, 0) != UNZ_OK
+      || memcmp(in->raw, in->out, in->rawlen) != 0) {
+    fprintf(stderr, "  %-24s decode failed\n", "far");
+    g_failed = true;
+    bench_unload(in);
+    return false;
+  }
+  return true;
+}
+
+/* far back copies into an output larger than l2 */
+static void
+bench_far(void) {
+  bench_input_t in;
+  double        sec;
+
+  if (!bench_far_make(&in, (size_t)64 << 20))
+    return;
+
+  sec = bench_best(bench_buf_run, &in);
+  printf("  %-24s %9zu B  %8.1f MB/s\n", "far_copies", in.rawlen,
+         (double)in.rawlen / sec / 1e6);
+  bench_unload(&in);
+}
+
+/* stored blocks only, copied to dst with streaming stores under INFL_NOCACHE */
+static bool
+bench_stored_make(bench_input_t *in, size_t size) {
+  uint32_t rng;
+  size_t   pos, n, i;
+  uint8_t *p;
+
+  memset(in, 0, sizeof(*in));
+  in->rawlen  = size;
+  in->outlen  = size + 1000;
+  in->complen = size + (size / 65535 + 1) * 5;
+  if (!(in->raw  = malloc(size))
+      || !(in->out  = malloc(in->outlen))
+      || !(in->comp = malloc(in->complen))) {
+    bench_unload(in);
+    return false;
+  }
+
+  rng = 0x29u;
+  for (i = 0; i < size; i++)
+    in->raw[i] = (uint8_t)bench_rand(&rng);
+
+  for (p = in->comp, pos = 0; pos < size; pos += n) {
+    n    = size - pos < 65535 ? size - pos : 65535;
+    p[0] = pos + n == size; /* BFINAL, BTYPE 00 */
+    p[1] = (uint8_t)n;
+    p[2] = (uint8_t)(n >> 8);
+    p[3] = (uint8_t)~n;
+    p[4] = (uint8_t)(~n >> 8);
+    memcpy(p + 5, in->raw + pos, n);
+    p   += 5 + n;
+  }
+  in->complen = (size_t)(p - in->comp);
+  return true;
+}
+
+/* the co-located workload: sums a buffer that fits the caches until told to
+   stop, its rate drops as the decode evicts the buffer */
+typedef struct bench_scan_t {
+  const uint64_t *buf;
+  size_t          n;
+  volatile bool   stop;
+  volatile size_t passes;
+  uint64_t        sum;
+} bench_scan_t;
+
+static void
+bench_scan_run(bench_scan_t *sc) {
+  uint64_t sum;
+  size_t   i;
+
+  sum = 0;
+  while (!sc->stop) {
+    for (i = 0; i < sc->n; i++)
+      sum += sc->buf[i];
+    sc->passes++;
+  }
+  sc->sum = sum;
+}
+
+#ifdef _WIN32
+static DWORD WINAPI
+bench_scan_main(void *arg) {
+  bench_scan_run(arg);
+  return 0;
+}
+#else
+static void *
+bench_scan_main(void *arg) {
+  bench_scan_run(arg);
+  return NULL;
+}
+#endif
+
+typedef struct bench_nocache_t {
+  bench_input_t *in;
+  int            flags;
+} bench_nocache_t;
+
+static void
+bench_nocache_run(void *arg) {
+  bench_nocache_t *job = arg;
+  infl_buf(job->in->comp, job->in->complen, job->in->out, job->in->outlen,
+           job->flags);
+}
+
+/* decode rate, and the scan rate of the other thread meanwhile */
+static void
+bench_nocache_one(const char *name, bench_input_t *in, bench_scan_t *sc,
+                  int flags) {
+  bench_nocache_t job;
+  double          sec, start, elapsed;
+  size_t          passes;
+#ifdef _WIN32
+  HANDLE          thread;
+#else
+  pthread_t       thread;
+#endif
+
+  if (infl_buf(in->comp, in->complen, in->out, in->outlen, flags) != UNZ_OK
+      || memcmp(in->raw, in->out, in->rawlen) != 0) {
+    fprintf(stderr, "  %-24s decode failed\n", name);
+    g_failed = true;
+    return;
+  }
+
+  job.in    = in;
+  job.flags = flags;
+  sc->stop  = false;
+
+#ifdef _WIN32
+  if (!(thread = CreateThread(NULL, 0, bench_scan_main, sc, 0, NULL)))
+    return;
+#else
+  if (pthread_create(&thread, NULL, bench_scan_main, sc) != 0)
+    return;
+#endif
+
+  start    = get_time();
+  passes   = sc->passes;
+  sec      = bench_best(bench_nocache_run, &job);
+  passes   = sc->passes - passes;
+  elapsed  = get_time() - start;
+  sc->stop = true;
+
+#ifdef _WIN32
+  WaitForSingleObject(thread, INFINITE);
+  CloseHandle(thread);
+#else
+  pthread_join(thread, NULL);
+#endif
+
+  printf("  %-24s %9zu B  %8.1f MB/s  scan %8.1f MB/s\n", name, in->rawlen,
+         (double)in->rawlen / sec / 1e6,
+         (double)passes * (double)(sc->n * sizeof(*sc->buf)) / elapsed / 1e6);
+}
+
+static void
+bench_nocache(void) {
+  bench_input_t in;
+  bench_scan_t  sc;
+  uint64_t     *buf;
+  size_t        i;
+
+  memset(&sc, 0, sizeof(sc));
+  sc.n = ((size_t)4 << 20) / sizeof(*buf);
+  if (!(buf = malloc(sc.n * sizeof(*buf))))
+    return;
+  for (i = 0; i < sc.n; i++)
+    buf[i] = i;
+  sc.buf = buf;
+
+  if (bench_stored_make(&in, (size_t)64 << 20)) {
+    bench_nocache_one("stored",          &in, &sc, 0);
+    bench_nocache_one("stored, nocache", &in, &sc, INFL_NOCACHE);
+    bench_unload(&in);
+  }
+
+  if (bench_far_make(&in, (size_t)64 << 20)) {
+    bench_nocache_one("huffman",          &in, &sc, 0);
+    bench_nocache_one("huffman, nocache", &in, &sc, INFL_NOCACHE);
+    bench_unload(&in);
+  }
+
+  free(buf);
+}
+
+/* a stored block with a 10-byte payload, small enough to be copied into the
+   stream's pages by infl_include() */
+static const uint8_t bench_short_z[] = {
+  0x01, 0x0a, 0x00, 0xf5, 0xff, 'h', 'e', 'l', 'l', 'o', ' ', 'b', 'e', 'n', 'c'
+};
+
+static void
+bench_print_ns(const char *name, double sec) {
+  printf("  %-24s %8.1f ns\n", name, sec * 1e9);
+}
+
+#ifdef __linux__
+static long
+bench_resident(void) {
+  FILE *f;
+  long  size, pages;
+
+  pages = 0;
+  if ((f = fopen("/proc/self/statm", "r"))) {
+    if (fscanf(f, "%ld %ld", &size, &pages) != 2)
+      pages = 0;
+    fclose(f);
+  }
+  return pages * sysconf(_SC_PAGESIZE);
+}
+#endif
+
+/* resident bytes per live stream, untouched parts of the pages do not count */
+static void
+bench_rss(void) {
+#ifdef __linux__
+  enum { NSTREAMS = 20000 };
+  infl_stream_t **st;
+  long            before, after;
+  int             i, n;
+
+  if (!(st = calloc(NSTREAMS, sizeof(*st))))
+    return;
+
+  before = bench_resident();
+  for (n = 0; n < NSTREAMS; n++) {
+    if (!(st[n] = infl_init(NULL, 0, 0)))
+      break;
+    infl_include(st[n], bench_short_z, sizeof(bench_short_z));
+  }
+  after = bench_resident();
+
+  if (n && before && after > before)
+    printf("  %-24s %9ld B\n", "resident, 10 B input", (after - before) / n);
+
+  for (i = 0; i < n; i++)
+    infl_destroy(st[i]);
+  free(st);
+#endif
+}
+
+static void
+bench_init_run(void *arg) {
+  infl_destroy(infl_init(arg, 64, 0));
+}
+
+static void
+bench_init_decode_run(void *arg) {
+  infl_stream_t *st;
+
+  if ((st = infl_init(arg, 64, 0))) {
+    infl_include(st, bench_short_z, sizeof(bench_short_z));
+    infl(st);
+    infl_destroy(st);
+  }
+}
+
+/* what a stream costs before it has decoded much: its footprint with a short
+   payload included and the setup and teardown latency */
+static void
+bench_streams(void) {
+  infl_stream_t *st;
+  uint8_t        out[64];
+  size_t         inuse;
+
+  if (!(st = infl_init(out, sizeof(out), 0)))
+    return;
+
+  infl_include(st, bench_short_z, sizeof(bench_short_z));
+  infl_mem_usage(st, &inuse, NULL);
+  if (infl(st) != UNZ_OK || memcmp(out, bench_short_z + 5, 10) != 0) {
+    fprintf(stderr, "  %-24s decode failed\n", "streams");
+    g_failed = true;
+  }
+  infl_destroy(st);
+
+  printf("  %-24s %9zu B\n", "allocated, 10 B input", inuse);
+  bench_rss();
+
+  bench_print_ns("init + destroy",          bench_best(bench_init_run,        out));
+  bench_print_ns("init + decode + destroy", bench_best(bench_init_decode_run, out));
+}
+
+static void
+bench_new_run(void *arg) {
+  bench_input_t *in = arg;
+  infl_stream_t *st;
+
+  if ((st = infl_init(in->out, in->outlen, 0))) {
+    infl_include(st, in->comp, in->complen);
+    infl(st);
+    infl_destroy(st);
+  }
+}
+
+static void
+bench_acquire_run(void *arg) {
+  bench_input_t *in = arg;
+  infl_stream_t *st;
+
+  if ((st = infl_acquire(in->out, in->outlen, 0))) {
+    infl_include(st, in->comp, in->complen);
+    infl(st);
+    infl_release(st);
+  }
+}
+
+static void
+bench_once_run(void *arg) {
+  bench_input_t *in = arg;
+  infl_once(in->comp, in->complen, in->out, in->outlen, 0, NULL, NULL);
+}
+
+/* short request payloads: a stream per decode against the thread's cache */
+static void
+bench_acquire(void) {
+  static const char * const files[] = {
+    "dynamic_huffman_1", "html", "c_source", "csv_data", "distance_test_4096",
+    NULL
+  };
+  bench_input_t in;
+  double        tnew, tacq, tonce;
+  size_t        i;
+
+  printf("  %-24s %9s    %10s %10s %10s\n", "", "", "init", "acquire", "once");
+  for (i = 0; files[i]; i++) {
+    if (!bench_load(files[i], &in))
+      continue;
+
+    tnew  = bench_best(bench_new_run,     &in);
+    tacq  = bench_best(bench_acquire_run, &in);
+    tonce = bench_best(bench_once_run,    &in);
+    printf("  %-24s %9zu B  %7.1f ns %7.1f ns %7.1f ns\n", files[i], in.rawlen,
+           tnew * 1e9, tacq * 1e9, tonce * 1e9);
+    bench_unload(&in);
+  }
+  infl_cache_depth(0);
+}
+
+typedef struct bench_case_t {
+  const char *name;
+  void      (*run)(void);
+} bench_case_t;
+
+static const bench_case_t bench_cases[] = {
+  {"tables",  bench_tables},
+  {"matches", bench_matches},
+  {"far",     bench_far},
+  {"nocache", bench_nocache},
+  {"streams", bench_streams},
+  {"acquire", bench_acquire},
+};
+
+int
+main(int argc, char *argv[]) {
+  size_t i;
+  int    a, nsel;
+  bool   sel[ARRAY_LEN(bench_cases)];
+
+  memset(sel, 0, sizeof(sel));
+  nsel = 0;
+
+  for (a = 1; a < argc; a++) {
+    if (!strcmp(argv[a], "-r") && a + 1 < argc) {
+      if ((g_rounds = atoi(argv[++a])) < 1)
+        g_rounds = 1;
+      continue;
+    }
+
+    for (i = 0; i < ARRAY_LEN(bench_cases); i++) {
+      if (!strcmp(argv[a], bench_cases[i].name))
+        break;
+    }
+
+    if (i == ARRAY_LEN(bench_cases)) {
+      fprintf(stderr, "unknown case %s\n", argv[a]);
+      return 1;
+    }
+    sel[i] = true;
+    nsel++;
+  }
+
+  for (i = 0; i < ARRAY_LEN(bench_cases); i++) {
+    if (nsel && !sel[i])
+      continue;
+
+    printf("%s (best of %d)\n", bench_cases[i].name, g_rounds);
+    bench_cases[i].run();
+  }
+
+  return g_failed ? 1 : 0;
+}
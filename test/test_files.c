@@ -36,6 +36,7 @@
 #else
 #include <dirent.h>
 #include <unistd.h>
+#include <pthread.h>
 #endif
 
 /* error reporting and colorful output */
@@ -210,7 +211,7 @@ test_file(const char *filename) {
   }
 
   /* initialize DEFLATE stream */
-  stream = infl_init(output, (uint32_t)orig_size + 1000, 0);
+  stream = infl_init(output, orig_size + 1000, 0);
   if (!stream) {
     snprintf(err_msg, sizeof(err_msg), "stream init failed");
     free(orig_data);
@@ -223,7 +224,7 @@ test_file(const char *filename) {
   }
 
   /* include compressed data */
-  infl_include(stream, compr_data, (uint32_t)compr_size);
+  infl_include(stream, compr_data, compr_size);
 
   /* decompress */
   ret = infl(stream);
@@ -284,7 +285,7 @@ test_file_chunked(const char *filename) {
   /* decompress in chunks (like PNG IDAT) */
   output = calloc(1, orig_size + 1000);
 
-  if (!(stream = infl_init(output, (uint32_t)orig_size + 1000, 0))) {
+  if (!(stream = infl_init(output, orig_size + 1000, 0))) {
     snprintf(err_msg, sizeof(err_msg), "stream init failed");
     free(orig_data);
     free(compr_data);
@@ -302,7 +303,7 @@ test_file_chunked(const char *filename) {
     chunk_size = 1ULL << (pos % 4);
     if (chunk_size > 512) chunk_size = 512;
     if (pos + chunk_size > compr_size) chunk_size = compr_size - pos;
-    infl_include(stream, compr_data + pos, (uint32_t)chunk_size);
+    infl_include(stream, compr_data + pos, chunk_size);
     pos += chunk_size;
   }
 
@@ -330,6 +331,84 @@ test_file_chunked(const char *filename) {
   free(output);
 }
 
+/* test decompression of input that stays split across several chunks: pieces
+   up to 8KB are appended into 32KB pages, larger ones are referenced directly */
+static void
+test_file_multichunk(const char *filename, size_t piece, size_t small) {
+  uint8_t       *orig_data, *output, *compr_data;
+  infl_stream_t *stream;
+  char           raw_path[512],compr_path[512],test_name[256],err_msg[256]={0},details[64]={0};
+  double         start_time, elapsed;
+  size_t         orig_size, compr_size, pos, chunk_size;
+  int            ret, nchunks;
+  bool           passed;
+
+  start_time = get_time();
+
+  if (small)
+    snprintf(test_name, sizeof(test_name), "%s_multichunk_%zu_%zu", filename, piece, small);
+  else
+    snprintf(test_name, sizeof(test_name), "%s_multichunk_%zu",     filename, piece);
+  snprintf(raw_path,   sizeof(raw_path),   "data/raw/%s",        filename);
+  snprintf(compr_path, sizeof(compr_path), "data/compressed/%s", filename);
+
+  if (!(orig_data = read_file(raw_path, &orig_size))) return;
+
+  if (!(compr_data = read_file(compr_path, &compr_size))) {
+    free(orig_data);
+    return;
+  }
+
+  output = calloc(1, orig_size + 1000);
+
+  if (!(stream = infl_init(output, orig_size + 1000, 0))) {
+    snprintf(err_msg, sizeof(err_msg), "stream init failed");
+    free(orig_data);
+    free(compr_data);
+    free(output);
+    g_results.failed++;
+    g_results.total++;
+    print_test_result(test_name, false, get_time() - start_time, err_msg, NULL);
+    return;
+  }
+
+  /* odd first piece so chunk edges never line up with words or blocks. with
+     small set, every other piece is a tiny chunk of its own between two
+     directly referenced ones */
+  pos     = 0;
+  nchunks = 0;
+  while (pos < compr_size) {
+    chunk_size = !pos ? 1 : (small && (nchunks & 1) == 0) ? small : piece;
+    if (pos + chunk_size > compr_size) chunk_size = compr_size - pos;
+    infl_include(stream, compr_data + pos, chunk_size);
+    pos += chunk_size;
+    nchunks++;
+  }
+
+  ret = infl(stream);
+
+  g_results.total++;
+  passed = (ret == UNZ_OK && memcmp(orig_data, output, orig_size) == 0);
+  if (!passed) {
+    if (ret != UNZ_OK) snprintf(err_msg, sizeof(err_msg), "multichunk decompression error %d", ret);
+    else               snprintf(err_msg, sizeof(err_msg), "multichunk data mismatch");
+    g_results.failed++;
+  } else {
+    g_results.passed++;
+    snprintf(details, sizeof(details), "%d includes", nchunks);
+  }
+
+  elapsed = get_time() - start_time;
+  g_results.total_time += elapsed;
+  print_test_result(test_name, passed, elapsed,
+                    passed ? NULL : err_msg, passed ? details : NULL);
+
+  infl_destroy(stream);
+  free(orig_data);
+  free(compr_data);
+  free(output);
+}
+
 /* list files in directory - Windows/POSIX compatible */
 static char**
 list_files(const char *dir, int *count) {
@@ -438,7 +517,7 @@ test_expect_inflate_error(const char    *name,
   memset(err_msg, 0, sizeof(err_msg));
   memset(details, 0, sizeof(details));
 
-  ret    = infl_buf(src, (uint32_t)srclen, output, sizeof(output), flags);
+  ret    = infl_buf(src, srclen, output, sizeof(output), flags);
   passed = (ret != UNZ_OK);
 
   if (!passed) {
@@ -720,7 +799,7 @@ test_file_streaming(const char *filename) {
     return;
   }
 
-  stream = infl_init(output, (uint32_t)orig_size + 1000, 0);
+  stream = infl_init(output, orig_size + 1000, 0);
   if (!stream) {
     snprintf(err_msg, sizeof(err_msg), "stream init failed");
     free(orig_data);
@@ -742,7 +821,7 @@ test_file_streaming(const char *filename) {
     chunk_size = 64 << (chunk_count % 5);
     if (pos + chunk_size > compr_size) chunk_size = compr_size - pos;
 
-    result = infl_stream(stream, comp_data + pos, (uint32_t)chunk_size);
+    result = infl_stream(stream, comp_data + pos, chunk_size);
     pos   += chunk_size;
     chunk_count++;
 
@@ -790,23 +869,23 @@ test_file_streaming(const char *filename) {
 }
 
 static void
-test_file_streaming_bytewise(const char *filename) {
+test_file_streaming_efull(const char *filename, size_t step) {
   double         start_time, elapsed;
   char           test_name[256], err_msg[256], details[64];
   char           raw_path[512], compr_path[512];
   uint8_t       *orig_data, *comp_data, *output;
   infl_stream_t *stream;
-  size_t         orig_size, compr_size, pos;
-  int            result, empty_attempts;
+  size_t         orig_size, compr_size, pos, chunk_size, visible, total;
+  int            result, resizes;
   bool           passed;
 
   start_time = get_time();
   memset(err_msg, 0, sizeof(err_msg));
   memset(details, 0, sizeof(details));
 
-  snprintf(test_name,  sizeof(test_name),  "%s_streaming_1byte", filename);
-  snprintf(raw_path,   sizeof(raw_path),   "data/raw/%s",        filename);
-  snprintf(compr_path, sizeof(compr_path), "data/compressed/%s", filename);
+  snprintf(test_name,  sizeof(test_name),  "%s_streaming_efull_%zu", filename, step);
+  snprintf(raw_path,   sizeof(raw_path),   "data/raw/%s",             filename);
+  snprintf(compr_path, sizeof(compr_path), "data/compressed/%s",      filename);
 
   if (!(orig_data = read_file(raw_path,   &orig_size)))  { return; }
   if (!(comp_data = read_file(compr_path, &compr_size))) {
@@ -814,7 +893,8 @@ test_file_streaming_bytewise(const char *filename) {
     return;
   }
 
-  if (!(output = calloc(1, orig_size + 1000))) {
+  total = orig_size + 1000;
+  if (!(output = calloc(1, total))) {
     snprintf(err_msg, sizeof(err_msg), "allocation failed");
     free(orig_data);
     free(comp_data);
@@ -824,7 +904,9 @@ test_file_streaming_bytewise(const char *filename) {
     return;
   }
 
-  stream = infl_init(output, (uint32_t)orig_size + 1000, 0);
+  /* expose the output in small windows so blocks stop at arbitrary points */
+  visible = step < total ? step : total;
+  stream  = infl_init(output, visible, 0);
   if (!stream) {
     snprintf(err_msg, sizeof(err_msg), "stream init failed");
     free(orig_data);
@@ -836,25 +918,37 @@ test_file_streaming_bytewise(const char *filename) {
     return;
   }
 
-  result = UNZ_UNFINISHED;
-  for (pos = 0; pos < compr_size && result == UNZ_UNFINISHED; pos++) {
-    result = infl_stream(stream, comp_data + pos, 1);
-  }
+  pos     = 0;
+  resizes = 0;
+  result  = UNZ_UNFINISHED;
 
-  empty_attempts = 0;
-  while (result == UNZ_UNFINISHED && empty_attempts++ < 32) {
-    result = infl_stream(stream, NULL, 0);
+  while (result == UNZ_UNFINISHED || result == UNZ_EFULL) {
+    if (result == UNZ_EFULL) {
+      if (visible >= total)
+        break;
+      visible = total - visible > step ? visible + step : total;
+      if (infl_resize_output(stream, output, visible) != UNZ_OK)
+        break;
+      resizes++;
+      result = infl_stream(stream, NULL, 0);
+    } else if (pos < compr_size) {
+      chunk_size = compr_size - pos > 1000 ? 1000 : compr_size - pos;
+      result     = infl_stream(stream, comp_data + pos, chunk_size);
+      pos       += chunk_size;
+    } else {
+      break;
+    }
   }
 
   g_results.total++;
   passed = (result == UNZ_OK && memcmp(orig_data, output, orig_size) == 0);
   if (!passed) {
-    if (result != UNZ_OK) snprintf(err_msg, sizeof(err_msg), "bytewise streaming error %d", result);
-    else                  snprintf(err_msg, sizeof(err_msg), "bytewise streaming data mismatch");
+    if (result != UNZ_OK) snprintf(err_msg, sizeof(err_msg), "efull streaming error %d", result);
+    else                  snprintf(err_msg, sizeof(err_msg), "efull streaming data mismatch");
     g_results.failed++;
   } else {
     g_results.passed++;
-    snprintf(details, sizeof(details), "%zu one-byte chunks", compr_size);
+    snprintf(details, sizeof(details), "%d resizes", resizes);
   }
 
   elapsed = get_time() - start_time;
@@ -868,135 +962,1396 @@ test_file_streaming_bytewise(const char *filename) {
   free(output);
 }
 
+/* infl_stream_borrow(): pieces go through one buffer that is overwritten as
+   soon as the stream released it, step > 0 exposes the output in windows */
 static void
-test_streaming_edge_cases(void) {
+test_file_borrow(const char *filename, size_t piece, size_t step) {
   double         start_time, elapsed;
-  char           err_msg[256], details[64];
-  char           zlib_path[512];
-  uint8_t        output[100];
-  uint8_t        large_uncompressed[100];
-  uint8_t       *zlib_data;
+  char           test_name[256], err_msg[256], details[64];
+  char           raw_path[512], compr_path[512];
+  uint8_t       *orig_data, *comp_data, *output, *buf;
   infl_stream_t *stream;
-  size_t         zlib_size, large_size, pos, fed, chunk;
-  int            result, attempts;
+  size_t         orig_size, compr_size, pos, add, have, used, cap, visible, total;
+  int            result;
   bool           passed;
 
-  /* test 1: uncompressed block with reasonable chunks */
-  const uint8_t uncompressed[] = {
-    0x01, 0x05, 0x00, 0xFA, 0xFF,  /* 5 bytes uncompressed */
-    'H', 'e', 'l', 'l', 'o'
-  };
-
   start_time = get_time();
   memset(err_msg, 0, sizeof(err_msg));
   memset(details, 0, sizeof(details));
 
-  stream = infl_init(output, sizeof(output), 0);
+  snprintf(test_name,  sizeof(test_name),  "%s_borrow_%zu_%zu", filename, piece, step);
+  snprintf(raw_path,   sizeof(raw_path),   "data/raw/%s",        filename);
+  snprintf(compr_path, sizeof(compr_path), "data/compressed/%s", filename);
 
-  /* feed all at once for small data (under 64 bytes) */
-  result = infl_stream(stream, uncompressed, sizeof(uncompressed));
+  if (!(orig_data = read_file(raw_path,   &orig_size)))  { return; }
+  if (!(comp_data = read_file(compr_path, &compr_size))) {
+    free(orig_data);
+    return;
+  }
 
-  passed = ((result == UNZ_OK || result == UNZ_UNFINISHED)
-            && memcmp(output, "Hello", 5) == 0);
+  total  = orig_size + 1000;
+  cap    = piece + 64;
+  output = calloc(1, total);
+  buf    = malloc(cap);
+  if (!output || !buf) {
+    free(orig_data);
+    free(comp_data);
+    free(output);
+    free(buf);
+    return;
+  }
+
+  visible = step && step < total ? step : total;
+  if (!(stream = infl_init(output, visible, 0))) {
+    snprintf(err_msg, sizeof(err_msg), "stream init failed");
+    free(orig_data);
+    free(comp_data);
+    free(output);
+    free(buf);
+    g_results.failed++;
+    g_results.total++;
+    print_test_result(test_name, false, get_time() - start_time, err_msg, NULL);
+    return;
+  }
+
+  pos    = 0;
+  have   = 0;
+  result = UNZ_UNFINISHED;
+
+  while (result == UNZ_UNFINISHED || result == UNZ_EFULL) {
+    if (result == UNZ_EFULL) {
+      if (visible >= total)
+        break;
+      visible = total - visible > step ? visible + step : total;
+      if (infl_resize_output(stream, output, visible) != UNZ_OK)
+        break;
+    } else {
+      if (pos >= compr_size)
+        break;
+      add = compr_size - pos > piece ? piece : compr_size - pos;
+      if (add > cap - have)
+        break;
+      memcpy(buf + have, comp_data + pos, add);
+      have += add;
+      pos  += add;
+    }
+
+    result = infl_stream_borrow(stream, buf, have, &used);
+
+    /* the released part must not be read again */
+    memmove(buf, buf + used, have - used);
+    have -= used;
+    memset(buf + have, 0xA5, cap - have);
+  }
+
+  g_results.total++;
+  passed = (result == UNZ_OK && pos - have == compr_size
+            && infl_input_pos(stream) == compr_size
+            && infl_output_pos(stream) == orig_size
+            && memcmp(orig_data, output, orig_size) == 0);
   if (!passed) {
-    snprintf(err_msg, sizeof(err_msg), "small data streaming failed, result=%d", result);
+    if (result != UNZ_OK) snprintf(err_msg, sizeof(err_msg), "borrow error %d", result);
+    else                  snprintf(err_msg, sizeof(err_msg), "borrow consumed %zu, input pos %zu",
+                                   pos - have, infl_input_pos(stream));
     g_results.failed++;
   } else {
     g_results.passed++;
-    snprintf(details, sizeof(details), "small data streaming");
+    snprintf(details, sizeof(details), "%zu bytes", orig_size);
   }
-  g_results.total++;
 
   elapsed = get_time() - start_time;
   g_results.total_time += elapsed;
-  print_test_result("small_data_streaming", passed, elapsed,
+  print_test_result(test_name, passed, elapsed,
                     passed ? NULL : err_msg, passed ? details : NULL);
 
   infl_destroy(stream);
+  free(orig_data);
+  free(comp_data);
+  free(output);
+  free(buf);
+}
 
-  /* test 2: ZLIB header streaming */
-  start_time = get_time();
-
-  /* use a working ZLIB stream from the test files instead */
-  snprintf(zlib_path, sizeof(zlib_path), "data/compressed/zlib_1");
-
-  zlib_data = read_file(zlib_path, &zlib_size);
-  if (zlib_data) {
-    /* test with actual ZLIB file */
-    stream   = infl_init(output, sizeof(output), INFL_ZLIB);
+/* infl_init_grow(): streamed in 1000 byte chunks or inflated with infl() */
+static void
+test_file_grow(const char *filename, size_t hint, bool streamed) {
+  double         start_time, elapsed;
+  char           test_name[256], err_msg[256], details[64];
+  char           raw_path[512], compr_path[512];
+  uint8_t       *orig_data, *comp_data, *output;
+  infl_stream_t *stream;
+  size_t         orig_size, compr_size, pos, chunk_size, outlen;
+  int            result;
+  bool           passed;
 
-    /* feed in small chunks */
-    result   = UNZ_UNFINISHED;
-    pos      = 0;
-    attempts = 0;
+  start_time = get_time();
+  memset(err_msg, 0, sizeof(err_msg));
+  memset(details, 0, sizeof(details));
 
-    while (pos < zlib_size && result == UNZ_UNFINISHED && attempts < 20) {
-      chunk = (zlib_size - pos > 8) ? 8 : (zlib_size - pos);
-      result = infl_stream(stream, zlib_data + pos, (uint32_t)chunk);
-      pos += chunk;
-      attempts++;
-    }
+  snprintf(test_name,  sizeof(test_name),  "%s_grow_%zu%s", filename, hint,
+           streamed ? "_streaming" : "");
+  snprintf(raw_path,   sizeof(raw_path),   "data/raw/%s",        filename);
+  snprintf(compr_path, sizeof(compr_path), "data/compressed/%s", filename);
 
-    /* try empty calls to complete */
-    while (result == UNZ_UNFINISHED && attempts < 30) {
-      result = infl_stream(stream, NULL, 0);
-      attempts++;
-    }
+  if (!(orig_data = read_file(raw_path,   &orig_size)))  { return; }
+  if (!(comp_data = read_file(compr_path, &compr_size))) {
+    free(orig_data);
+    return;
+  }
 
-    passed = (result == UNZ_OK);
-    if (!passed) {
-      snprintf(err_msg, sizeof(err_msg), "zlib streaming failed, result=%d", result);
-    } else {
-      snprintf(details, sizeof(details), "zlib streaming");
-    }
+  if (!(stream = infl_init_grow(hint, 0))) {
+    snprintf(err_msg, sizeof(err_msg), "grow init failed");
+    free(orig_data);
+    free(comp_data);
+    g_results.failed++;
+    g_results.total++;
+    print_test_result(test_name, false, get_time() - start_time, err_msg, NULL);
+    return;
+  }
 
-    /* cleanup */
-    infl_destroy(stream);
-    free(zlib_data);
+  if (!streamed) {
+    infl_include(stream, comp_data, compr_size);
+    result = infl(stream);
   } else {
-    /* fallback to simple test without ZLIB */
-    const uint8_t simple_deflate[] = {
-      0x01, 0x03, 0x00, 0xFC, 0xFF,  /* 3 bytes uncompressed */
-      'A', 'B', 'C'
-    };
-
-    stream = infl_init(output, sizeof(output), 0);
-    result = infl_stream(stream, simple_deflate, sizeof(simple_deflate));
-
-    passed = (result == UNZ_OK && memcmp(output, "ABC", 3) == 0);
-    if (!passed) {
-      snprintf(err_msg, sizeof(err_msg), "fallback streaming failed, result=%d", result);
-    } else {
-      snprintf(details, sizeof(details), "raw DEFLATE");
+    pos    = 0;
+    result = UNZ_UNFINISHED;
+    while (result == UNZ_UNFINISHED && pos < compr_size) {
+      chunk_size = compr_size - pos > 1000 ? 1000 : compr_size - pos;
+      result     = infl_stream(stream, comp_data + pos, chunk_size);
+      pos       += chunk_size;
     }
-
-    infl_destroy(stream);
   }
 
-  if (passed) { g_results.passed++; }
-  else        { g_results.failed++; }
+  output = infl_take_output(stream, &outlen);
+  infl_destroy(stream);
+
   g_results.total++;
+  passed = (result == UNZ_OK && output && outlen == orig_size
+            && memcmp(orig_data, output, orig_size) == 0);
+  if (!passed) {
+    if (result != UNZ_OK) snprintf(err_msg, sizeof(err_msg), "grow error %d", result);
+    else                  snprintf(err_msg, sizeof(err_msg), "grow data mismatch");
+    g_results.failed++;
+  } else {
+    g_results.passed++;
+    snprintf(details, sizeof(details), "%zu bytes", outlen);
+  }
 
   elapsed = get_time() - start_time;
   g_results.total_time += elapsed;
-  print_test_result("zlib_header_streaming", passed, elapsed,
+  print_test_result(test_name, passed, elapsed,
                     passed ? NULL : err_msg, passed ? details : NULL);
 
-  /* test 3: Chunked streaming with realistic sizes */
-  start_time = get_time();
-  stream     = infl_init(output, sizeof(output), 0);
+  free(output);
+  free(orig_data);
+  free(comp_data);
+}
 
-  /* create larger test data */
-  large_size = 0;
+/* infl_init_iov(): separately allocated segments of mixed sizes, half given
+   up front and the rest after UNZ_EFULL */
+static void
+test_file_iov(const char *filename, size_t seglen, bool streamed) {
+  static const size_t mul[4] = {1, 0, 3, 0};
+  double         start_time, elapsed;
+  char           test_name[256], err_msg[256], details[64];
+  char           raw_path[512], compr_path[512];
+  uint8_t       *orig_data, *comp_data;
+  infl_stream_t *stream;
+  infl_iov_t    *iov;
+  size_t         orig_size, compr_size, pos, chunk_size, niov, total, i, half;
+  int            result, refills;
+  bool           passed;
 
-  /* build an uncompressed block with 95 bytes */
-  large_uncompressed[large_size++] = 0x01;  /* BFINAL=1, BTYPE=00 */
-  large_uncompressed[large_size++] = 95;    /* LEN low */
-  large_uncompressed[large_size++] = 0;     /* LEN high */
-  large_uncompressed[large_size++] = ~95;   /* NLEN low */
-  large_uncompressed[large_size++] = 0xFF;  /* NLEN high */
+  start_time = get_time();
+  memset(err_msg, 0, sizeof(err_msg));
+  memset(details, 0, sizeof(details));
 
-  /* add 95 bytes of data */
+  snprintf(test_name,  sizeof(test_name),  "%s_iov_%zu%s", filename, seglen,
+           streamed ? "_streaming" : "");
+  snprintf(raw_path,   sizeof(raw_path),   "data/raw/%s",        filename);
+  snprintf(compr_path, sizeof(compr_path), "data/compressed/%s", filename);
+
+  if (!(orig_data = read_file(raw_path,   &orig_size)))  { return; }
+  if (!(comp_data = read_file(compr_path, &compr_size))) {
+    free(orig_data);
+    return;
+  }
+
+  /* lengths seglen, 1, 3 * seglen + 7, 0, ... until the output fits */
+  niov  = 0;
+  total = 0;
+  iov   = calloc(orig_size / seglen + 8, sizeof(*iov));
+  while (iov && total < orig_size + 1000) {
+    iov[niov].len  = seglen * mul[niov % 4] + (niov % 4 == 1) + (niov % 4 == 2) * 7;
+    iov[niov].base = malloc(iov[niov].len + 1);
+    total         += iov[niov++].len;
+  }
+
+  half   = niov / 2;
+  stream = iov ? infl_init_iov(iov, half, 0) : NULL;
+  if (!stream) {
+    snprintf(err_msg, sizeof(err_msg), "iov init failed");
+    for (i = 0; iov && i < niov; i++) free(iov[i].base);
+    free(iov);
+    free(orig_data);
+    free(comp_data);
+    g_results.failed++;
+    g_results.total++;
+    print_test_result(test_name, false, get_time() - start_time, err_msg, NULL);
+    return;
+  }
+
+  refills = 0;
+  if (!streamed) {
+    infl_include(stream, comp_data, compr_size);
+    result = infl(stream);
+  } else {
+    pos    = 0;
+    result = UNZ_UNFINISHED;
+    while (result == UNZ_UNFINISHED && pos < compr_size) {
+      chunk_size = compr_size - pos > 1000 ? 1000 : compr_size - pos;
+      result     = infl_stream(stream, comp_data + pos, chunk_size);
+      pos       += chunk_size;
+      if (result == UNZ_EFULL && !refills++) {
+        infl_add_iov(stream, iov + half, niov - half);
+        result = infl_stream(stream, NULL, 0);
+      }
+    }
+  }
+  if (result == UNZ_EFULL && !refills++) {
+    infl_add_iov(stream, iov + half, niov - half);
+    result = infl_stream(stream, NULL, 0);
+  }
+
+  passed = (result == UNZ_OK && infl_output_pos(stream) == orig_size);
+  for (i = 0, pos = 0; passed && i < niov && pos < orig_size; i++) {
+    chunk_size = orig_size - pos < iov[i].len ? orig_size - pos : iov[i].len;
+    passed     = memcmp(orig_data + pos, iov[i].base, chunk_size) == 0;
+    pos       += chunk_size;
+  }
+
+  g_results.total++;
+  if (!passed) {
+    if (result != UNZ_OK) snprintf(err_msg, sizeof(err_msg), "iov error %d", result);
+    else                  snprintf(err_msg, sizeof(err_msg), "iov data mismatch");
+    g_results.failed++;
+  } else {
+    g_results.passed++;
+    snprintf(details, sizeof(details), "%zu segments", niov);
+  }
+
+  elapsed = get_time() - start_time;
+  g_results.total_time += elapsed;
+  print_test_result(test_name, passed, elapsed,
+                    passed ? NULL : err_msg, passed ? details : NULL);
+
+  infl_destroy(stream);
+  for (i = 0; i < niov; i++) free(iov[i].base);
+  free(iov);
+  free(orig_data);
+  free(comp_data);
+}
+
+typedef struct sink_ctx_t {
+  uint8_t *buf;
+  size_t   cap;
+  size_t   len;
+  size_t   slice;
+  size_t   calls;
+  bool     short_seen; /* a slice shorter than the size must be the last */
+  bool     bad;
+} sink_ctx_t;
+
+static int
+test_sink(void *ctx, const uint8_t *p, size_t len) {
+  sink_ctx_t *sc = ctx;
+
+  sc->calls++;
+  if (sc->short_seen || len > sc->slice || len > sc->cap - sc->len) {
+    sc->bad = true;
+    return UNZ_ERR;
+  }
+  if (len < sc->slice)
+    sc->short_seen = true;
+
+  memcpy(sc->buf + sc->len, p, len);
+  sc->len += len;
+  return UNZ_OK;
+}
+
+/* infl_init_sink(): slice 0 inflates the whole input with infl(), others
+   stream it in 1000 byte chunks */
+static void
+test_file_sink(const char *filename, size_t slice) {
+  double         start_time, elapsed;
+  char           test_name[256], err_msg[256], details[64];
+  char           raw_path[512], compr_path[512];
+  uint8_t       *orig_data, *comp_data;
+  infl_stream_t *stream;
+  sink_ctx_t     sc;
+  size_t         orig_size, compr_size, pos, chunk_size;
+  int            result;
+  bool           passed;
+
+  start_time = get_time();
+  memset(err_msg, 0, sizeof(err_msg));
+  memset(details, 0, sizeof(details));
+  memset(&sc, 0, sizeof(sc));
+
+  snprintf(test_name,  sizeof(test_name),  "%s_sink_%zu",  filename, slice);
+  snprintf(raw_path,   sizeof(raw_path),   "data/raw/%s",        filename);
+  snprintf(compr_path, sizeof(compr_path), "data/compressed/%s", filename);
+
+  if (!(orig_data = read_file(raw_path,   &orig_size)))  { return; }
+  if (!(comp_data = read_file(compr_path, &compr_size))) {
+    free(orig_data);
+    return;
+  }
+
+  sc.cap   = orig_size + 1000;
+  sc.slice = slice ? slice : 65536;
+  if (!(sc.buf = calloc(1, sc.cap))
+      || !(stream = infl_init_sink(test_sink, &sc, slice, 0))) {
+    snprintf(err_msg, sizeof(err_msg), "sink init failed");
+    free(sc.buf);
+    free(orig_data);
+    free(comp_data);
+    g_results.failed++;
+    g_results.total++;
+    print_test_result(test_name, false, get_time() - start_time, err_msg, NULL);
+    return;
+  }
+
+  if (!slice) {
+    infl_include(stream, comp_data, compr_size);
+    result = infl(stream);
+  } else {
+    pos    = 0;
+    result = UNZ_UNFINISHED;
+    while (result == UNZ_UNFINISHED && pos < compr_size) {
+      chunk_size = compr_size - pos > 1000 ? 1000 : compr_size - pos;
+      result     = infl_stream(stream, comp_data + pos, chunk_size);
+      pos       += chunk_size;
+    }
+  }
+
+  g_results.total++;
+  passed = (result == UNZ_OK && !sc.bad && sc.len == orig_size
+            && infl_output_pos(stream) == orig_size
+            && memcmp(orig_data, sc.buf, orig_size) == 0);
+  if (!passed) {
+    if (result != UNZ_OK) snprintf(err_msg, sizeof(err_msg), "sink error %d", result);
+    else if (sc.bad)      snprintf(err_msg, sizeof(err_msg), "sink slice %zu wrong", sc.calls);
+    else                  snprintf(err_msg, sizeof(err_msg), "sink data mismatch");
+    g_results.failed++;
+  } else {
+    g_results.passed++;
+    snprintf(details, sizeof(details), "%zu slices", sc.calls);
+  }
+
+  elapsed = get_time() - start_time;
+  g_results.total_time += elapsed;
+  print_test_result(test_name, passed, elapsed,
+                    passed ? NULL : err_msg, passed ? details : NULL);
+
+  infl_destroy(stream);
+  free(sc.buf);
+  free(orig_data);
+  free(comp_data);
+}
+
+static void
+test_file_streaming_bytewise(const char *filename) {
+  double         start_time, elapsed;
+  char           test_name[256], err_msg[256], details[64];
+  char           raw_path[512], compr_path[512];
+  uint8_t       *orig_data, *comp_data, *output;
+  infl_stream_t *stream;
+  size_t         orig_size, compr_size, pos;
+  int            result, empty_attempts;
+  bool           passed;
+
+  start_time = get_time();
+  memset(err_msg, 0, sizeof(err_msg));
+  memset(details, 0, sizeof(details));
+
+  snprintf(test_name,  sizeof(test_name),  "%s_streaming_1byte", filename);
+  snprintf(raw_path,   sizeof(raw_path),   "data/raw/%s",        filename);
+  snprintf(compr_path, sizeof(compr_path), "data/compressed/%s", filename);
+
+  if (!(orig_data = read_file(raw_path,   &orig_size)))  { return; }
+  if (!(comp_data = read_file(compr_path, &compr_size))) {
+    free(orig_data);
+    return;
+  }
+
+  if (!(output = calloc(1, orig_size + 1000))) {
+    snprintf(err_msg, sizeof(err_msg), "allocation failed");
+    free(orig_data);
+    free(comp_data);
+    g_results.failed++;
+    g_results.total++;
+    print_test_result(test_name, false, get_time() - start_time, err_msg, NULL);
+    return;
+  }
+
+  stream = infl_init(output, orig_size + 1000, 0);
+  if (!stream) {
+    snprintf(err_msg, sizeof(err_msg), "stream init failed");
+    free(orig_data);
+    free(comp_data);
+    free(output);
+    g_results.failed++;
+    g_results.total++;
+    print_test_result(test_name, false, get_time() - start_time, err_msg, NULL);
+    return;
+  }
+
+  result = UNZ_UNFINISHED;
+  for (pos = 0; pos < compr_size && result == UNZ_UNFINISHED; pos++) {
+    result = infl_stream(stream, comp_data + pos, 1);
+  }
+
+  empty_attempts = 0;
+  while (result == UNZ_UNFINISHED && empty_attempts++ < 32) {
+    result = infl_stream(stream, NULL, 0);
+  }
+
+  g_results.total++;
+  passed = (result == UNZ_OK && memcmp(orig_data, output, orig_size) == 0);
+  if (!passed) {
+    if (result != UNZ_OK) snprintf(err_msg, sizeof(err_msg), "bytewise streaming error %d", result);
+    else                  snprintf(err_msg, sizeof(err_msg), "bytewise streaming data mismatch");
+    g_results.failed++;
+  } else {
+    g_results.passed++;
+    snprintf(details, sizeof(details), "%zu one-byte chunks", compr_size);
+  }
+
+  elapsed = get_time() - start_time;
+  g_results.total_time += elapsed;
+  print_test_result(test_name, passed, elapsed,
+                    passed ? NULL : err_msg, passed ? details : NULL);
+
+  infl_destroy(stream);
+  free(orig_data);
+  free(comp_data);
+  free(output);
+}
+
+/* INFL_NOCACHE only changes how dst is written, the output must not change */
+static void
+test_file_nocache(const char *filename) {
+  double   start_time, elapsed;
+  char     test_name[256], err_msg[256], details[64];
+  char     raw_path[512], compr_path[512];
+  uint8_t *orig_data, *comp_data, *output;
+  size_t   orig_size, compr_size;
+  int      result;
+  bool     passed;
+
+  start_time = get_time();
+  memset(err_msg, 0, sizeof(err_msg));
+  memset(details, 0, sizeof(details));
+
+  snprintf(test_name,  sizeof(test_name),  "%s_nocache", filename);
+  snprintf(raw_path,   sizeof(raw_path),   "data/raw/%s",        filename);
+  snprintf(compr_path, sizeof(compr_path), "data/compressed/%s", filename);
+
+  if (!(orig_data = read_file(raw_path,   &orig_size)))  { return; }
+  if (!(comp_data = read_file(compr_path, &compr_size))) {
+    free(orig_data);
+    return;
+  }
+
+  if (!(output = calloc(1, orig_size + 1000))) {
+    snprintf(err_msg, sizeof(err_msg), "allocation failed");
+    free(orig_data);
+    free(comp_data);
+    g_results.failed++;
+    g_results.total++;
+    print_test_result(test_name, false, get_time() - start_time, err_msg, NULL);
+    return;
+  }
+
+  result = infl_buf(comp_data, compr_size, output,
+                    orig_size + 1000, INFL_NOCACHE);
+  passed = (result == UNZ_OK && memcmp(orig_data, output, orig_size) == 0);
+
+  g_results.total++;
+  if (!passed) {
+    if (result != UNZ_OK) snprintf(err_msg, sizeof(err_msg), "nocache error %d", result);
+    else                  snprintf(err_msg, sizeof(err_msg), "nocache data mismatch");
+    g_results.failed++;
+  } else {
+    g_results.passed++;
+    snprintf(details, sizeof(details), "%zu bytes", orig_size);
+  }
+
+  elapsed = get_time() - start_time;
+  g_results.total_time += elapsed;
+  print_test_result(test_name, passed, elapsed,
+                    passed ? NULL : err_msg, passed ? details : NULL);
+
+  free(orig_data);
+  free(comp_data);
+  free(output);
+}
+
+/* infl_once(): whole input at once without a heap stream, the counts must
+   cover exactly the output and the compressed data */
+static void
+test_file_once(const char *filename) {
+  double   start_time, elapsed;
+  char     test_name[256], err_msg[256], details[64];
+  char     raw_path[512], compr_path[512];
+  uint8_t *orig_data, *comp_data, *output;
+  size_t   orig_size, compr_size, produced, consumed;
+  int      result;
+  bool     passed;
+
+  start_time = get_time();
+  memset(err_msg, 0, sizeof(err_msg));
+  memset(details, 0, sizeof(details));
+
+  snprintf(test_name,  sizeof(test_name),  "%s_once", filename);
+  snprintf(raw_path,   sizeof(raw_path),   "data/raw/%s",        filename);
+  snprintf(compr_path, sizeof(compr_path), "data/compressed/%s", filename);
+
+  if (!(orig_data = read_file(raw_path,   &orig_size)))  { return; }
+  if (!(comp_data = read_file(compr_path, &compr_size))) {
+    free(orig_data);
+    return;
+  }
+
+  if (!(output = calloc(1, orig_size + 1000))) {
+    free(orig_data);
+    free(comp_data);
+    return;
+  }
+
+  produced = consumed = SIZE_MAX;
+  result   = infl_once(comp_data, compr_size, output, orig_size + 1000, 0,
+                       &produced, &consumed);
+  passed   = (result == UNZ_OK && produced == orig_size && consumed == compr_size
+              && memcmp(orig_data, output, orig_size) == 0);
+
+  g_results.total++;
+  if (!passed) {
+    if (result != UNZ_OK) snprintf(err_msg, sizeof(err_msg), "once error %d", result);
+    else                  snprintf(err_msg, sizeof(err_msg), "once produced %zu consumed %zu",
+                                   produced, consumed);
+    g_results.failed++;
+  } else {
+    g_results.passed++;
+    snprintf(details, sizeof(details), "%zu bytes", produced);
+  }
+
+  elapsed = get_time() - start_time;
+  g_results.total_time += elapsed;
+  print_test_result(test_name, passed, elapsed,
+                    passed ? NULL : err_msg, passed ? details : NULL);
+
+  free(orig_data);
+  free(comp_data);
+  free(output);
+}
+
+typedef struct alloc_ctx_t {
+  size_t inuse;
+  size_t peak;
+  size_t budget;
+} alloc_ctx_t;
+
+/* counts and caps what a stream holds, no realloc so the stream copies */
+static void *
+test_alloc(void *ctx, size_t size, size_t align) {
+  alloc_ctx_t *ac = ctx;
+  uint8_t     *p, *q;
+
+  if (size > ac->budget - ac->inuse)
+    return NULL;
+  if (align < 16)
+    align = 16;
+  if (!(p = malloc(size + align + sizeof(void *))))
+    return NULL;
+
+  q = (uint8_t *)(((uintptr_t)p + sizeof(void *) + align - 1) & ~(uintptr_t)(align - 1));
+  ((void **)q)[-1] = p;
+
+  ac->inuse += size;
+  if (ac->inuse > ac->peak)
+    ac->peak = ac->inuse;
+  return q;
+}
+
+static void
+test_free(void *ctx, void *p, size_t size) {
+  alloc_ctx_t *ac = ctx;
+
+  if (!p)
+    return;
+  ac->inuse -= size;
+  free(((void **)p)[-1]);
+}
+
+/* infl_init_ex(): all memory from a counting allocator. budget caps it, a
+   tight one may fail the inflate but must not leak or crash */
+static void
+test_file_alloc(const char *filename, size_t budget) {
+  double         start_time, elapsed;
+  char           test_name[256], err_msg[256], details[64];
+  char           raw_path[512], compr_path[512];
+  uint8_t       *orig_data, *comp_data, *output;
+  infl_stream_t *stream;
+  alloc_ctx_t    ac;
+  infl_alloc_t   alloc;
+  size_t         orig_size, compr_size, pos, piece, inuse, peak, first;
+  int            result, round;
+  bool           passed;
+
+  start_time = get_time();
+  memset(err_msg, 0, sizeof(err_msg));
+  memset(details, 0, sizeof(details));
+  memset(&ac, 0, sizeof(ac));
+
+  snprintf(test_name,  sizeof(test_name),  "%s_alloc_%zu", filename, budget);
+  snprintf(raw_path,   sizeof(raw_path),   "data/raw/%s",        filename);
+  snprintf(compr_path, sizeof(compr_path), "data/compressed/%s", filename);
+
+  if (!(orig_data = read_file(raw_path,   &orig_size)))  { return; }
+  if (!(comp_data = read_file(compr_path, &compr_size))) {
+    free(orig_data);
+    return;
+  }
+
+  if (!(output = calloc(1, orig_size + 1000))) {
+    free(orig_data);
+    free(comp_data);
+    return;
+  }
+
+  ac.budget     = budget ? budget : SIZE_MAX;
+  alloc.alloc   = test_alloc;
+  alloc.realloc = NULL;
+  alloc.free    = test_free;
+  alloc.ctx     = &ac;
+
+  g_results.total++;
+  if (!(stream = infl_init_ex(output, orig_size + 1000, 0, &alloc))) {
+    snprintf(err_msg, sizeof(err_msg), "init failed");
+    passed = false;
+    goto done;
+  }
+
+  /* small pieces fill the chunk pages, the rest go in place. the second
+     round must get by with what the first one allocated */
+  first = 0;
+  for (round = 0; round < 2; round++) {
+    if (round) {
+      first = ac.inuse;
+      memset(output, 0, orig_size);
+      infl_reset(stream, output, orig_size + 1000, 0);
+    }
+    for (pos = 0; pos < compr_size; pos += piece) {
+      piece = compr_size - pos > 100 ? 100 : compr_size - pos;
+      infl_include(stream, comp_data + pos, piece);
+    }
+    result = infl(stream);
+  }
+
+  infl_mem_usage(stream, &inuse, &peak);
+  passed = inuse == ac.inuse && peak == ac.peak && inuse == first;
+  if (!passed)
+    snprintf(err_msg, sizeof(err_msg), "usage %zu/%zu, allocator %zu/%zu, first %zu",
+             inuse, peak, ac.inuse, ac.peak, first);
+
+  infl_destroy(stream);
+  if (passed && ac.inuse != 0) {
+    snprintf(err_msg, sizeof(err_msg), "%zu bytes left", ac.inuse);
+    passed = false;
+  }
+
+  if (passed && !budget) {
+    passed = result == UNZ_OK && memcmp(orig_data, output, orig_size) == 0;
+    if (!passed) {
+      if (result != UNZ_OK) snprintf(err_msg, sizeof(err_msg), "alloc error %d", result);
+      else                  snprintf(err_msg, sizeof(err_msg), "alloc data mismatch");
+    }
+  } else if (passed && result == UNZ_OK) {
+    passed = memcmp(orig_data, output, orig_size) == 0;
+    if (!passed)
+      snprintf(err_msg, sizeof(err_msg), "alloc data mismatch");
+  }
+
+done:
+  if (!passed) {
+    g_results.failed++;
+  } else {
+    g_results.passed++;
+    snprintf(details, sizeof(details), "peak %zu bytes", ac.peak);
+  }
+
+  elapsed = get_time() - start_time;
+  g_results.total_time += elapsed;
+  print_test_result(test_name, passed, elapsed,
+                    passed ? NULL : err_msg, passed ? details : NULL);
+
+  free(orig_data);
+  free(comp_data);
+  free(output);
+}
+
+/* infl_init_grow_ex(): the output grows through a counting allocator with no
+   realloc, the taken output is freed through it with its length */
+static void
+test_file_grow_alloc(const char *filename) {
+  double         start_time, elapsed;
+  char           test_name[256], err_msg[256], details[64];
+  char           raw_path[512], compr_path[512];
+  uint8_t       *orig_data, *comp_data, *output;
+  infl_stream_t *stream;
+  alloc_ctx_t    ac;
+  infl_alloc_t   alloc;
+  size_t         orig_size, compr_size, outlen;
+  int            result;
+  bool           passed;
+
+  start_time = get_time();
+  memset(err_msg, 0, sizeof(err_msg));
+  memset(details, 0, sizeof(details));
+  memset(&ac, 0, sizeof(ac));
+
+  snprintf(test_name,  sizeof(test_name),  "%s_grow_alloc", filename);
+  snprintf(raw_path,   sizeof(raw_path),   "data/raw/%s",        filename);
+  snprintf(compr_path, sizeof(compr_path), "data/compressed/%s", filename);
+
+  if (!(orig_data = read_file(raw_path,   &orig_size)))  { return; }
+  if (!(comp_data = read_file(compr_path, &compr_size))) {
+    free(orig_data);
+    return;
+  }
+
+  ac.budget     = SIZE_MAX;
+  alloc.alloc   = test_alloc;
+  alloc.realloc = NULL;
+  alloc.free    = test_free;
+  alloc.ctx     = &ac;
+
+  g_results.total++;
+  if (!(stream = infl_init_grow_ex(1000, 0, &alloc))) {
+    snprintf(err_msg, sizeof(err_msg), "grow init failed");
+    passed = false;
+    goto done;
+  }
+
+  infl_include(stream, comp_data, compr_size);
+  result = infl(stream);
+  output = infl_take_output(stream, &outlen);
+  infl_destroy(stream);
+
+  passed = result == UNZ_OK && output && outlen == orig_size
+           && memcmp(orig_data, output, orig_size) == 0;
+  if (!passed) {
+    if (result != UNZ_OK) snprintf(err_msg, sizeof(err_msg), "grow error %d", result);
+    else                  snprintf(err_msg, sizeof(err_msg), "grow data mismatch");
+  } else if (ac.inuse != outlen) {
+    snprintf(err_msg, sizeof(err_msg), "%zu bytes held for %zu of output",
+             ac.inuse, outlen);
+    passed = false;
+  }
+
+  alloc.free(alloc.ctx, output, outlen);
+  if (passed && ac.inuse != 0) {
+    snprintf(err_msg, sizeof(err_msg), "%zu bytes left", ac.inuse);
+    passed = false;
+  }
+
+done:
+  if (!passed) {
+    g_results.failed++;
+  } else {
+    g_results.passed++;
+    snprintf(details, sizeof(details), "%zu bytes, peak %zu bytes", outlen, ac.peak);
+  }
+
+  elapsed = get_time() - start_time;
+  g_results.total_time += elapsed;
+  print_test_result(test_name, passed, elapsed,
+                    passed ? NULL : err_msg, passed ? details : NULL);
+
+  free(orig_data);
+  free(comp_data);
+}
+
+/* infl_acquire(): the second decode must get the released stream back and
+   need no more memory, depth 0 empties the cache again */
+static void
+test_file_acquire(const char *filename) {
+  double         start_time, elapsed;
+  char           test_name[256], err_msg[256], details[64];
+  char           raw_path[512], compr_path[512];
+  uint8_t       *orig_data, *comp_data, *output;
+  infl_stream_t *stream, *prev;
+  size_t         orig_size, compr_size, pos, piece, inuse, first;
+  int            result, round;
+  bool           passed;
+
+  start_time = get_time();
+  memset(err_msg, 0, sizeof(err_msg));
+  memset(details, 0, sizeof(details));
+
+  snprintf(test_name,  sizeof(test_name),  "%s_acquire", filename);
+  snprintf(raw_path,   sizeof(raw_path),   "data/raw/%s",        filename);
+  snprintf(compr_path, sizeof(compr_path), "data/compressed/%s", filename);
+
+  if (!(orig_data = read_file(raw_path,   &orig_size)))  { return; }
+  if (!(comp_data = read_file(compr_path, &compr_size))) {
+    free(orig_data);
+    return;
+  }
+
+  if (!(output = calloc(1, orig_size + 1000))) {
+    free(orig_data);
+    free(comp_data);
+    return;
+  }
+
+  infl_cache_depth(1);
+
+  passed = true;
+  prev   = NULL;
+  first  = 0;
+  for (round = 0; round < 2 && passed; round++) {
+    memset(output, 0, orig_size);
+    if (!(stream = infl_acquire(output, orig_size + 1000, 0))) {
+      snprintf(err_msg, sizeof(err_msg), "acquire failed");
+      passed = false;
+      break;
+    }
+
+    for (pos = 0; pos < compr_size; pos += piece) {
+      piece = compr_size - pos > 100 ? 100 : compr_size - pos;
+      infl_include(stream, comp_data + pos, piece);
+    }
+    result = infl(stream);
+    infl_mem_usage(stream, &inuse, NULL);
+
+    if (result != UNZ_OK || memcmp(orig_data, output, orig_size) != 0) {
+      if (result != UNZ_OK) snprintf(err_msg, sizeof(err_msg), "acquire error %d", result);
+      else                  snprintf(err_msg, sizeof(err_msg), "acquire data mismatch");
+      passed = false;
+    } else if (round && (stream != prev || inuse != first)) {
+      snprintf(err_msg, sizeof(err_msg), "not reused, %zu bytes vs %zu", inuse, first);
+      passed = false;
+    }
+
+    prev  = stream;
+    first = inuse;
+    infl_release(stream);
+  }
+
+  infl_cache_depth(0);
+
+  g_results.total++;
+  if (!passed) {
+    g_results.failed++;
+  } else {
+    g_results.passed++;
+    snprintf(details, sizeof(details), "%zu bytes kept", first);
+  }
+
+  elapsed = get_time() - start_time;
+  g_results.total_time += elapsed;
+  print_test_result(test_name, passed, elapsed,
+                    passed ? NULL : err_msg, passed ? details : NULL);
+
+  free(orig_data);
+  free(comp_data);
+  free(output);
+}
+
+typedef struct acquire_job_t {
+  const uint8_t *comp, *orig;
+  size_t         compr_size, orig_size;
+  int            result;
+} acquire_job_t;
+
+static void
+acquire_job_run(acquire_job_t *job) {
+  infl_stream_t *stream;
+  uint8_t       *output;
+
+  job->result = UNZ_ENOMEM;
+  if (!(output = calloc(1, job->orig_size + 1000)))
+    return;
+
+  if ((stream = infl_acquire(output, job->orig_size + 1000, 0))) {
+    infl_include(stream, job->comp, job->compr_size);
+    job->result = infl(stream);
+    if (job->result == UNZ_OK && memcmp(job->orig, output, job->orig_size) != 0)
+      job->result = UNZ_ERR;
+    infl_release(stream);
+  }
+  free(output);
+}
+
+#ifdef _WIN32
+static DWORD WINAPI
+acquire_job_main(void *arg) {
+  acquire_job_run(arg);
+  return 0;
+}
+#else
+static void *
+acquire_job_main(void *arg) {
+  acquire_job_run(arg);
+  return NULL;
+}
+#endif
+
+/* infl_acquire() on a thread that exits with its stream still cached, the
+   exit frees the cache. valgrind and the sanitizers report it otherwise */
+static void
+test_file_acquire_thread(const char *filename) {
+  double        start_time, elapsed;
+  char          test_name[256], err_msg[256];
+  char          raw_path[512], compr_path[512];
+  uint8_t      *orig_data, *comp_data;
+  acquire_job_t job;
+  bool          passed;
+
+  start_time = get_time();
+  memset(err_msg, 0, sizeof(err_msg));
+
+  snprintf(test_name,  sizeof(test_name),  "%s_acquire_thread", filename);
+  snprintf(raw_path,   sizeof(raw_path),   "data/raw/%s",        filename);
+  snprintf(compr_path, sizeof(compr_path), "data/compressed/%s", filename);
+
+  if (!(orig_data = read_file(raw_path,   &job.orig_size)))  { return; }
+  if (!(comp_data = read_file(compr_path, &job.compr_size))) {
+    free(orig_data);
+    return;
+  }
+
+  job.orig   = orig_data;
+  job.comp   = comp_data;
+  job.result = UNZ_ERR;
+
+#ifdef _WIN32
+  {
+    HANDLE thread;
+
+    if ((thread = CreateThread(NULL, 0, acquire_job_main, &job, 0, NULL))) {
+      WaitForSingleObject(thread, INFINITE);
+      CloseHandle(thread);
+    }
+  }
+#else
+  {
+    pthread_t thread;
+
+    if (pthread_create(&thread, NULL, acquire_job_main, &job) == 0)
+      pthread_join(thread, NULL);
+  }
+#endif
+
+  passed = job.result == UNZ_OK;
+  if (!passed)
+    snprintf(err_msg, sizeof(err_msg), "acquire thread error %d", job.result);
+
+  g_results.total++;
+  if (!passed) g_results.failed++;
+  else         g_results.passed++;
+
+  elapsed = get_time() - start_time;
+  g_results.total_time += elapsed;
+  print_test_result(test_name, passed, elapsed, passed ? NULL : err_msg, NULL);
+
+  free(orig_data);
+  free(comp_data);
+}
+
+/* infl_view(): the runs read in order must give the original, stored payloads
+   in place and the huffman blocks after them in dst with their window */
+static void
+test_file_view(const char *filename) {
+  double            start_time, elapsed;
+  char              test_name[256], err_msg[256], details[64];
+  char              raw_path[512], compr_path[512];
+  uint8_t          *orig_data, *comp_data, *output;
+  infl_stream_t    *stream;
+  const infl_seg_t *segs;
+  size_t            orig_size, compr_size, nsegs, total, inplace, i;
+  int               result;
+  bool              passed;
+
+  start_time = get_time();
+  memset(err_msg, 0, sizeof(err_msg));
+  memset(details, 0, sizeof(details));
+
+  snprintf(test_name,  sizeof(test_name),  "%s_view", filename);
+  snprintf(raw_path,   sizeof(raw_path),   "data/raw/%s",        filename);
+  snprintf(compr_path, sizeof(compr_path), "data/compressed/%s", filename);
+
+  if (!(orig_data = read_file(raw_path,   &orig_size)))  { return; }
+  if (!(comp_data = read_file(compr_path, &compr_size))) {
+    free(orig_data);
+    return;
+  }
+
+  if (!(output = calloc(1, orig_size + 32768 + 1000))) {
+    snprintf(err_msg, sizeof(err_msg), "allocation failed");
+    free(orig_data);
+    free(comp_data);
+    g_results.failed++;
+    g_results.total++;
+    print_test_result(test_name, false, get_time() - start_time, err_msg, NULL);
+    return;
+  }
+
+  stream = infl_init(output, orig_size + 32768 + 1000, 0);
+  if (!stream) {
+    snprintf(err_msg, sizeof(err_msg), "stream init failed");
+    free(orig_data);
+    free(comp_data);
+    free(output);
+    g_results.failed++;
+    g_results.total++;
+    print_test_result(test_name, false, get_time() - start_time, err_msg, NULL);
+    return;
+  }
+
+  infl_include(stream, comp_data, compr_size);
+  result = infl_view(stream, &segs, &nsegs);
+
+  total   = 0;
+  inplace = 0;
+  passed  = (result == UNZ_OK);
+  for (i = 0; passed && i < nsegs; i++) {
+    if (segs[i].len > orig_size - total
+        || memcmp(orig_data + total, segs[i].ptr, segs[i].len) != 0) {
+      passed = false;
+      break;
+    }
+    if (segs[i].ptr < output || segs[i].ptr >= output + orig_size + 32768 + 1000)
+      inplace += segs[i].len;
+    total += segs[i].len;
+  }
+  passed = passed && total == orig_size;
+
+  g_results.total++;
+  if (!passed) {
+    if (result != UNZ_OK) snprintf(err_msg, sizeof(err_msg), "view error %d", result);
+    else                  snprintf(err_msg, sizeof(err_msg), "view data mismatch");
+    g_results.failed++;
+  } else {
+    g_results.passed++;
+    snprintf(details, sizeof(details), "%zu runs, %zu bytes in place", nsegs, inplace);
+  }
+
+  elapsed = get_time() - start_time;
+  g_results.total_time += elapsed;
+  print_test_result(test_name, passed, elapsed,
+                    passed ? NULL : err_msg, passed ? details : NULL);
+
+  infl_destroy(stream);
+  free(orig_data);
+  free(comp_data);
+  free(output);
+}
+
+/* infl_view() of stored blocks split into two direct chunks at every cut,
+   with no dst. a header that ends a few bytes before the cut leaves payload
+   bytes of the first chunk in the bit buffer, they must not need dst */
+static void
+test_view_split(void) {
+  double            start_time, elapsed;
+  char              err_msg[256], details[64];
+  uint8_t          *comp, *raw, *q;
+  infl_stream_t    *stream;
+  const infl_seg_t *segs;
+  size_t            complen, rawlen, nsegs, cut, total, i;
+  uint32_t          rng;
+  int               result;
+  bool              passed;
+
+  start_time = get_time();
+  memset(err_msg, 0, sizeof(err_msg));
+  memset(details, 0, sizeof(details));
+
+  rawlen  = 3 * 12000;
+  complen = rawlen + 3 * 5;
+  raw     = malloc(rawlen);
+  comp    = malloc(complen);
+  if (!raw || !comp) {
+    free(raw);
+    free(comp);
+    return;
+  }
+
+  rng = 1;
+  for (i = 0; i < rawlen; i++) {
+    rng    = rng * 1103515245u + 12345u;
+    raw[i] = (uint8_t)(rng >> 16);
+  }
+
+  for (q = comp, i = 0; i < 3; i++) {
+    q[0] = i == 2;                     /* BFINAL, BTYPE 00 */
+    q[1] = (uint8_t)(12000 & 0xff);
+    q[2] = (uint8_t)(12000 >> 8);
+    q[3] = (uint8_t)~(12000 & 0xff);
+    q[4] = (uint8_t)~(12000 >> 8);
+    memcpy(q + 5, raw + i * 12000, 12000);
+    q   += 5 + 12000;
+  }
+
+  passed = true;
+  result = UNZ_OK;
+  for (cut = 1; passed && cut < complen; cut++) {
+    if (!(stream = infl_init(NULL, 0, 0))) {
+      snprintf(err_msg, sizeof(err_msg), "stream init failed");
+      passed = false;
+      break;
+    }
+
+    infl_include(stream, comp, cut);
+    infl_include(stream, comp + cut, complen - cut);
+    result = infl_view(stream, &segs, &nsegs);
+
+    total  = 0;
+    passed = (result == UNZ_OK);
+    for (i = 0; passed && i < nsegs; i++) {
+      if (segs[i].len > rawlen - total
+          || memcmp(raw + total, segs[i].ptr, segs[i].len) != 0)
+        passed = false;
+      total += segs[i].len;
+    }
+    passed = passed && total == rawlen;
+
+    if (!passed) {
+      if (result != UNZ_OK)
+        snprintf(err_msg, sizeof(err_msg), "cut %zu: view error %d", cut, result);
+      else
+        snprintf(err_msg, sizeof(err_msg), "cut %zu: view data mismatch", cut);
+    }
+    infl_destroy(stream);
+  }
+
+  g_results.total++;
+  if (!passed) {
+    g_results.failed++;
+  } else {
+    g_results.passed++;
+    snprintf(details, sizeof(details), "%zu cuts, no dst", complen - 1);
+  }
+
+  elapsed = get_time() - start_time;
+  g_results.total_time += elapsed;
+  print_test_result("view_stored_split", passed, elapsed,
+                    passed ? NULL : err_msg, passed ? details : NULL);
+
+  free(raw);
+  free(comp);
+}
+
+/* every strict prefix of a complete stream must be rejected, even when the
+   missing bits would decode from the zero padding behind the input tail */
+static void
+test_file_truncated(const char *filename) {
+  double   start_time, elapsed;
+  char     test_name[256], err_msg[256], details[64];
+  char     raw_path[512], compr_path[512];
+  uint8_t *orig_data, *comp_data, *output;
+  size_t   orig_size, compr_size, len;
+  int      result;
+  bool     passed;
+
+  start_time = get_time();
+  memset(err_msg, 0, sizeof(err_msg));
+  memset(details, 0, sizeof(details));
+
+  snprintf(test_name,  sizeof(test_name),  "%s_truncated", filename);
+  snprintf(raw_path,   sizeof(raw_path),   "data/raw/%s",        filename);
+  snprintf(compr_path, sizeof(compr_path), "data/compressed/%s", filename);
+
+  if (!(orig_data = read_file(raw_path,   &orig_size)))  { return; }
+  if (!(comp_data = read_file(compr_path, &compr_size))) {
+    free(orig_data);
+    return;
+  }
+
+  if (!(output = calloc(1, orig_size + 1000))) {
+    snprintf(err_msg, sizeof(err_msg), "allocation failed");
+    free(orig_data);
+    free(comp_data);
+    g_results.failed++;
+    g_results.total++;
+    print_test_result(test_name, false, get_time() - start_time, err_msg, NULL);
+    return;
+  }
+
+  result = infl_buf(comp_data, compr_size, output,
+                    orig_size + 1000, 0);
+  passed = (result == UNZ_OK && memcmp(orig_data, output, orig_size) == 0);
+  if (!passed)
+    snprintf(err_msg, sizeof(err_msg), "complete stream failed, error %d", result);
+
+  for (len = 1; passed && len < compr_size; len++) {
+    result = infl_buf(comp_data, len, output,
+                      orig_size + 1000, 0);
+    if (result == UNZ_OK) {
+      snprintf(err_msg, sizeof(err_msg), "accepted %zu of %zu bytes", len, compr_size);
+      passed = false;
+    }
+  }
+
+  g_results.total++;
+  if (!passed) {
+    g_results.failed++;
+  } else {
+    g_results.passed++;
+    snprintf(details, sizeof(details), "%zu prefixes rejected", compr_size - 1);
+  }
+
+  elapsed = get_time() - start_time;
+  g_results.total_time += elapsed;
+  print_test_result(test_name, passed, elapsed,
+                    passed ? NULL : err_msg, passed ? details : NULL);
+
+  free(orig_data);
+  free(comp_data);
+  free(output);
+}
+
+static void
+test_streaming_edge_cases(void) {
+  double         start_time, elapsed;
+  char           err_msg[256], details[64];
+  char           zlib_path[512];
+  uint8_t        output[100];
+  uint8_t        large_uncompressed[100];
+  uint8_t       *zlib_data;
+  infl_stream_t *stream;
+  size_t         zlib_size, large_size, pos, fed, chunk;
+  int            result, attempts;
+  bool           passed;
+
+  /* test 1: uncompressed block with reasonable chunks */
+  const uint8_t uncompressed[] = {
+    0x01, 0x05, 0x00, 0xFA, 0xFF,  /* 5 bytes uncompressed */
+    'H', 'e', 'l', 'l', 'o'
+  };
+
+  start_time = get_time();
+  memset(err_msg, 0, sizeof(err_msg));
+  memset(details, 0, sizeof(details));
+
+  stream = infl_init(output, sizeof(output), 0);
+
+  /* feed all at once for small data (under 64 bytes) */
+  result = infl_stream(stream, uncompressed, sizeof(uncompressed));
+
+  passed = ((result == UNZ_OK || result == UNZ_UNFINISHED)
+            && memcmp(output, "Hello", 5) == 0);
+  if (!passed) {
+    snprintf(err_msg, sizeof(err_msg), "small data streaming failed, result=%d", result);
+    g_results.failed++;
+  } else {
+    g_results.passed++;
+    snprintf(details, sizeof(details), "small data streaming");
+  }
+  g_results.total++;
+
+  elapsed = get_time() - start_time;
+  g_results.total_time += elapsed;
+  print_test_result("small_data_streaming", passed, elapsed,
+                    passed ? NULL : err_msg, passed ? details : NULL);
+
+  infl_destroy(stream);
+
+  /* test 2: ZLIB header streaming */
+  start_time = get_time();
+
+  /* use a working ZLIB stream from the test files instead */
+  snprintf(zlib_path, sizeof(zlib_path), "data/compressed/zlib_1");
+
+  zlib_data = read_file(zlib_path, &zlib_size);
+  if (zlib_data) {
+    /* test with actual ZLIB file */
+    stream   = infl_init(output, sizeof(output), INFL_ZLIB);
+
+    /* feed in small chunks */
+    result   = UNZ_UNFINISHED;
+    pos      = 0;
+    attempts = 0;
+
+    while (pos < zlib_size && result == UNZ_UNFINISHED && attempts < 20) {
+      chunk = (zlib_size - pos > 8) ? 8 : (zlib_size - pos);
+      result = infl_stream(stream, zlib_data + pos, chunk);
+      pos += chunk;
+      attempts++;
+    }
+
+    /* try empty calls to complete */
+    while (result == UNZ_UNFINISHED && attempts < 30) {
+      result = infl_stream(stream, NULL, 0);
+      attempts++;
+    }
+
+    passed = (result == UNZ_OK);
+    if (!passed) {
+      snprintf(err_msg, sizeof(err_msg), "zlib streaming failed, result=%d", result);
+    } else {
+      snprintf(details, sizeof(details), "zlib streaming");
+    }
+
+    /* cleanup */
+    infl_destroy(stream);
+    free(zlib_data);
+  } else {
+    /* fallback to simple test without ZLIB */
+    const uint8_t simple_deflate[] = {
+      0x01, 0x03, 0x00, 0xFC, 0xFF,  /* 3 bytes uncompressed */
+      'A', 'B', 'C'
+    };
+
+    stream = infl_init(output, sizeof(output), 0);
+    result = infl_stream(stream, simple_deflate, sizeof(simple_deflate));
+
+    passed = (result == UNZ_OK && memcmp(output, "ABC", 3) == 0);
+    if (!passed) {
+      snprintf(err_msg, sizeof(err_msg), "fallback streaming failed, result=%d", result);
+    } else {
+      snprintf(details, sizeof(details), "raw DEFLATE");
+    }
+
+    infl_destroy(stream);
+  }
+
+  if (passed) { g_results.passed++; }
+  else        { g_results.failed++; }
+  g_results.total++;
+
+  elapsed = get_time() - start_time;
+  g_results.total_time += elapsed;
+  print_test_result("zlib_header_streaming", passed, elapsed,
+                    passed ? NULL : err_msg, passed ? details : NULL);
+
+  /* test 3: Chunked streaming with realistic sizes */
+  start_time = get_time();
+  stream     = infl_init(output, sizeof(output), 0);
+
+  /* create larger test data */
+  large_size = 0;
+
+  /* build an uncompressed block with 95 bytes */
+  large_uncompressed[large_size++] = 0x01;  /* BFINAL=1, BTYPE=00 */
+  large_uncompressed[large_size++] = 95;    /* LEN low */
+  large_uncompressed[large_size++] = 0;     /* LEN high */
+  large_uncompressed[large_size++] = ~95;   /* NLEN low */
+  large_uncompressed[large_size++] = 0xFF;  /* NLEN high */
+
+  /* add 95 bytes of data */
   for (int i = 0; i < 95; i++) {
     large_uncompressed[large_size++] = 'A' + (i % 26);
   }
@@ -1006,7 +2361,7 @@ test_streaming_edge_cases(void) {
   result = UNZ_UNFINISHED;
   while (fed < large_size && result == UNZ_UNFINISHED) {
     chunk  = (large_size - fed > 64) ? 64 : (large_size - fed);
-    result = infl_stream(stream, large_uncompressed + fed, (uint32_t)chunk);
+    result = infl_stream(stream, large_uncompressed + fed, chunk);
     fed   += chunk;
   }
 
@@ -1044,7 +2399,44 @@ int main(int argc, char *argv[]) {
     "hello", "hello_world", "json", "xml", "binary",
     "zeros_1k", "huffman_single_a", "multi_block_1",
     "dynamic_huffman_1", "distance_test_1", "length_test_3",
-    "bit_align_7", "zlib_1", NULL
+    "bit_align_7", "zlib_1", "huffman_only_digits", "full_flush_records", NULL
+  };
+
+  const char *efull_tests[] = {
+    "large_text_64k", "multi_block_1", "multiple_blocks", "pathological_2",
+    "zeros_64k", "huffman_only_digits", "period_3", "period_7",
+    "full_flush_records", NULL
+  };
+
+  const char *sink_tests[] = {
+    "large_text_64k", "multi_block_1", "multiple_blocks", "pathological_2",
+    "uncompressed_multi", "zeros_64k", "period_3", "stored_mix_window", NULL
+  };
+
+  const char *nocache_tests[] = {
+    "uncompressed_multi", "uncompressed_multi_exact", "multiple_blocks",
+    "stored_mix_window", "pathological_2", "long_blocks_1m", NULL
+  };
+
+  const char *alloc_tests[] = {
+    "png_simulation", "multiple_blocks", "pathological_2",
+    "uncompressed_multi", "multi_block_1", NULL
+  };
+
+  const char *view_tests[] = {
+    "uncompressed_multi", "uncompressed_multi_exact", "uncompressed_small",
+    "uncompressed_empty", "multi_block_1", "full_flush_records",
+    "stored_mix_window", NULL
+  };
+
+  const char *truncated_tests[] = {
+    "hello", "json", "huffman_single_a", "length_test_3", "bit_align_7",
+    "distance_test_1", "dynamic_huffman_1", "multi_block_1", NULL
+  };
+
+  const char *multichunk_tests[] = {
+    "png_simulation", "uncompressed_multi", "uncompressed_multi_exact",
+    "uncompressed_boundary_1", NULL
   };
 
   (void)argc; /* suppress unused parameter warning */
@@ -1102,6 +2494,22 @@ int main(int argc, char *argv[]) {
     }
   }
 
+  /* test subset split across pooled pages and direct chunks */
+  for (i = 0; multichunk_tests[i]; i++) {
+    found = false;
+    for (j = 0; j < file_count; j++) {
+      if (strcmp(files[j], multichunk_tests[i]) == 0) {
+        found = true;
+        break;
+      }
+    }
+    if (found) {
+      test_file_multichunk(multichunk_tests[i], 7001, 0);
+      test_file_multichunk(multichunk_tests[i], 9001, 0);
+      test_file_multichunk(multichunk_tests[i], 8193, 5);
+    }
+  }
+
   /* test streaming API */
   for (i = 0; streaming_tests[i]; i++) {
     /* check if this file exists in our list */
@@ -1114,6 +2522,143 @@ int main(int argc, char *argv[]) {
     }
     if (found) {
       test_file_streaming(streaming_tests[i]);
+      test_file_borrow(streaming_tests[i], 7, 0);
+      test_file_borrow(streaming_tests[i], 1000, 0);
+    }
+  }
+
+  /* test streaming with output exposed in small windows */
+  for (i = 0; efull_tests[i]; i++) {
+    found = false;
+    for (j = 0; j < file_count; j++) {
+      if (strcmp(files[j], efull_tests[i]) == 0) {
+        found = true;
+        break;
+      }
+    }
+    if (found) {
+      test_file_streaming_efull(efull_tests[i], 1237);
+      test_file_borrow(efull_tests[i], 1000, 1237);
+    }
+  }
+
+  /* test output grown by the stream, starting below the output size */
+  for (i = 0; sink_tests[i]; i++) {
+    found = false;
+    for (j = 0; j < file_count; j++) {
+      if (strcmp(files[j], sink_tests[i]) == 0) {
+        found = true;
+        break;
+      }
+    }
+    if (found) {
+      test_file_grow(sink_tests[i], 1000, false);
+      test_file_grow(sink_tests[i], 0, true);
+    }
+  }
+
+  /* test output spread over segments, matches reaching across them */
+  for (i = 0; sink_tests[i]; i++) {
+    found = false;
+    for (j = 0; j < file_count; j++) {
+      if (strcmp(files[j], sink_tests[i]) == 0) {
+        found = true;
+        break;
+      }
+    }
+    if (found) {
+      test_file_iov(sink_tests[i], 1000, true);
+      test_file_iov(sink_tests[i], 40000, false);
+    }
+  }
+
+  /* test output handed to a sink through a sliding window */
+  for (i = 0; sink_tests[i]; i++) {
+    found = false;
+    for (j = 0; j < file_count; j++) {
+      if (strcmp(files[j], sink_tests[i]) == 0) {
+        found = true;
+        break;
+      }
+    }
+    if (found) {
+      test_file_sink(sink_tests[i], 4096);
+      test_file_sink(sink_tests[i], 0);
+    }
+  }
+
+  /* test streaming stores and eviction of written output */
+  for (i = 0; nocache_tests[i]; i++) {
+    found = false;
+    for (j = 0; j < file_count; j++) {
+      if (strcmp(files[j], nocache_tests[i]) == 0) {
+        found = true;
+        break;
+      }
+    }
+    if (found) {
+      test_file_nocache(nocache_tests[i]);
+    }
+  }
+
+  /* test one-shot decoding without a heap stream */
+  for (i = 0; streaming_tests[i]; i++) {
+    found = false;
+    for (j = 0; j < file_count; j++) {
+      if (strcmp(files[j], streaming_tests[i]) == 0) {
+        found = true;
+        break;
+      }
+    }
+    if (found) {
+      test_file_once(streaming_tests[i]);
+    }
+  }
+
+  /* test decoding with memory from a counting, capped allocator */
+  for (i = 0; alloc_tests[i]; i++) {
+    found = false;
+    for (j = 0; j < file_count; j++) {
+      if (strcmp(files[j], alloc_tests[i]) == 0) {
+        found = true;
+        break;
+      }
+    }
+    if (found) {
+      test_file_alloc(alloc_tests[i], 0);
+      test_file_alloc(alloc_tests[i], 64 * 1024);
+      test_file_grow_alloc(alloc_tests[i]);
+      test_file_acquire(alloc_tests[i]);
+      test_file_acquire_thread(alloc_tests[i]);
+    }
+  }
+
+  /* test stored blocks returned in place */
+  for (i = 0; view_tests[i]; i++) {
+    found = false;
+    for (j = 0; j < file_count; j++) {
+      if (strcmp(files[j], view_tests[i]) == 0) {
+        found = true;
+        break;
+      }
+    }
+    if (found) {
+      test_file_view(view_tests[i]);
+    }
+  }
+  test_view_split();
+
+  /* test prefixes of complete streams */
+  for (i = 0; truncated_tests[i]; i++) {
+    found = false;
+    for (j = 0; j < file_count; j++) {
+      if (strcmp(files[j], truncated_tests[i]) == 0) {
+        found = true;
+        break;
+      }
+    }
+    if (found) {
+      test_file_truncated(truncated_tests[i]);
     }
   }
 
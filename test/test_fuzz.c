@@ -281,7 +281,7 @@ int main(int argc, char *argv[]) {
     }
 
     /* test decompression */
-    ret = infl_buf(data, (uint32_t)size, output, MAX_OUTPUT_SIZE, 0);
+    ret = infl_buf(data, size, output, MAX_OUTPUT_SIZE, 0);
     if (ret == UNZ_OK) {
       success++;
     } else if (ret == UNZ_ERR || ret == UNZ_EFULL) {